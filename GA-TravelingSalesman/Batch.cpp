@@ -0,0 +1,244 @@
+#include <iostream>     // cerr
+#include <sstream>      // ostringstream
+#include <vector>       // vector
+#include <deque>        // deque
+#include <mutex>        // mutex, lock_guard, unique_lock
+#include <condition_variable>
+#include <stdio.h>      // FILE, fdopen, fputs, fflush
+#include <errno.h>      // errno
+#include <signal.h>     // signal
+#include <unistd.h>     // close, dup
+#include <sys/socket.h> // accept
+#include <omp.h>        // OpenMP
+#include "Timer.h"
+#include "Tsplib.h"
+#include "Distributed.h"
+#include "Batch.h"
+
+using namespace std;
+
+// One instance of the stream
+struct Task {
+  long seq;
+  Instance instance;
+};
+
+// The deque of one worker
+struct alignas( 64 ) WorkQueue {
+  mutex lock;
+  deque<Task *> tasks;
+};
+
+// Work-stealing deques of the workers, and the counts the reader and the
+// idle workers wait on
+class Pool {
+public:
+  Pool( int nWorkers ) : nWorkers( nWorkers ), queues( nWorkers ), queued( 0 ), unfinished( 0 ),
+                         closing( false ) { }
+
+  // Reader: deals task to the deque of worker seq % nWorkers, once fewer
+  // than BATCH_BACKLOG tasks wait
+  void push( Task *task ) {
+    {
+      unique_lock<mutex> guard( state );
+      room.wait( guard, [this] { return queued < BATCH_BACKLOG; } );
+      queued++;
+      unfinished++;
+    }
+    {
+      WorkQueue &queue = queues[task->seq % nWorkers];
+      lock_guard<mutex> guard( queue.lock );
+      queue.tasks.push_back( task );
+    }
+    ready.notify_one( );
+  }
+
+  // Worker: the oldest task of its own deque, else the newest of another
+  // one; NULL once the pool is closed and no task is left
+  Task *take( int worker ) {
+    while ( true ) {
+      for ( int k = 0; k < nWorkers; k++ ) {
+        WorkQueue &queue = queues[( worker + k ) % nWorkers];
+        Task *task = NULL;
+        {
+          lock_guard<mutex> guard( queue.lock );
+          if ( queue.tasks.empty( ) )
+            continue;
+          if ( k == 0 ) {
+            task = queue.tasks.front( );
+            queue.tasks.pop_front( );
+          } else {
+            task = queue.tasks.back( );
+            queue.tasks.pop_back( );
+          }
+        }
+        {
+          lock_guard<mutex> guard( state );
+          queued--;
+        }
+        room.notify_one( );
+        return task;
+      }
+
+      // queued may count a task not yet in its deque: then look again
+      unique_lock<mutex> guard( state );
+      ready.wait( guard, [this] { return queued > 0 || closing; } );
+      if ( queued == 0 && closing )
+        return NULL;
+    }
+  }
+
+  // Worker: a task taken has been answered
+  void finished( ) {
+    lock_guard<mutex> guard( state );
+    if ( --unfinished == 0 )
+      drained.notify_all( );
+  }
+
+  // Reader: waits until every task pushed has been answered
+  void drain( ) {
+    unique_lock<mutex> guard( state );
+    drained.wait( guard, [this] { return unfinished == 0; } );
+  }
+
+  // Reader: no more tasks will come
+  void close( ) {
+    {
+      lock_guard<mutex> guard( state );
+      closing = true;
+    }
+    ready.notify_all( );
+  }
+
+private:
+  int nWorkers;
+  vector<WorkQueue> queues;
+  mutex state;                           // guards the counts below
+  condition_variable ready, room, drained;
+  long queued;                           // tasks pushed and not yet taken
+  long unfinished;                       // tasks pushed and not yet answered
+  bool closing;
+};
+
+// Where the results of the current stream go
+class Output {
+public:
+  Output( ) : file( NULL ) { }
+
+  void write( const string &line ) {
+    lock_guard<mutex> guard( lock );
+    fputs( line.c_str( ), file );
+    fflush( file );                      // stream each result as it finishes
+  }
+
+  FILE *file;
+
+private:
+  mutex lock;
+};
+
+/*
+ * Reads the instances of in into the pool until in ends, waits for all of
+ * them to be answered on out, and reports the throughput
+ */
+static void serveStream( FILE *in, FILE *out, Pool &pool, Output &output ) {
+  Timer timer;
+  timer.start( );
+  output.file = out;
+
+  long seq = 0;
+  while ( true ) {
+    Task *task = new Task;
+    string error;
+    task->seq = seq;
+    if ( !readTsplib( in, task->instance, error ) ) {
+      string name = task->instance.name.empty( ) ? "-" : task->instance.name;
+      delete task;
+      if ( error.empty( ) )
+        break;                           // end of the stream
+      ostringstream line;
+      line << seq++ << "\t" << name << "\terror: " << error << "\n";
+      output.write( line.str( ) );
+      continue;
+    }
+    seq++;
+    pool.push( task );
+  }
+  pool.drain( );
+
+  long usec = timer.lap( );
+  cerr << "batch: " << seq << " instances in " << usec << " usec = "
+       << seq * 1000000.0 / ( usec > 0 ? usec : 1 ) << " instances/sec" << endl;
+}
+
+/*
+ * Worker: solves tasks with its own Solver until the pool is closed
+ */
+static void work( int worker, const SolverOptions &options, Pool &pool, Output &output ) {
+  Solver solver( BATCH_POPULATION );
+  Solution solution;
+  Task *task;
+  while ( ( task = pool.take( worker ) ) != NULL ) {
+    solver.solve( task->instance, options, solution );
+
+    ostringstream line;
+    line << task->seq << "\t" << task->instance.name << "\t" << task->instance.n << "\t"
+         << solution.length << "\t" << solution.generations << "\t" << solution.usec << "\t";
+    for ( int i = 0; i < task->instance.n; i++ )
+      line << ( i > 0 ? " " : "" ) << solution.tour[i] + 1;
+    line << "\n";
+    output.write( line.str( ) );
+
+    delete task;
+    pool.finished( );
+  }
+}
+
+int runBatch( const char address[], int nThreads, const SolverOptions &options ) {
+  int listenFd = -1;
+  if ( address != NULL ) {
+    if ( ( listenFd = openSocket( address, true ) ) < 0 ) {
+      cerr << "cannot listen at " << address << endl;
+      return -1;
+    }
+    signal( SIGPIPE, SIG_IGN );          // a client may leave before its results
+  }
+  cerr << "batch: " << nThreads << " workers, seed = " << options.seed
+       << ", crossover = " << crossoverNames[options.op]
+       << ", local search = " << ( options.localSearch ? "on" : "off" ) << endl;
+
+  // each worker solves one instance at a time, on one thread
+  SolverOptions single = options;
+  single.threads = 1;
+  Pool pool( nThreads );
+  Output output;
+
+  // thread 0 reads, threads 1..nThreads are the workers
+  omp_set_dynamic( 0 );
+  #pragma omp parallel num_threads( nThreads + 1 )
+  {
+    int thread = omp_get_thread_num( );
+    if ( thread > 0 )
+      work( thread - 1, single, pool, output );
+    else {
+      if ( address == NULL )
+        serveStream( stdin, stdout, pool, output );
+      else
+        while ( true ) {
+          int fd = accept( listenFd, NULL, NULL );
+          if ( fd < 0 && errno == EINTR )
+            continue;
+          if ( fd < 0 )
+            break;
+          FILE *in = fdopen( fd, "r" ), *out = fdopen( dup( fd ), "w" );
+          serveStream( in, out, pool, output );
+          fclose( in );
+          fclose( out );
+        }
+      pool.close( );
+    }
+  }
+  if ( listenFd >= 0 )
+    close( listenFd );
+  return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "Solver.h"
+
+// Batch / service mode: a stream of independent TSPLIB EUC_2D instances (see
+// Tsplib.h), each ended by its EOF line, is solved by a pool of workers.
+//
+// The reading thread deals instances round-robin into the workers' deques.
+// A worker takes the oldest instance of its own deque and, once that is
+// empty, steals the newest one of another worker's, so a worker stuck on a
+// large instance does not hold up the ones queued behind it. Every worker
+// keeps one Solver, whose arena serves all the instances it solves.
+//
+// Results stream out in the order they finish, one line per instance:
+//
+//   seq  name  n  length  generations  usec  tour (node ids 1..n)
+//
+// where seq counts the instances of the stream from 0, or "seq name error:
+// why" for an instance that cannot be read.
+
+#define BATCH_POPULATION 200    // tours per population of a worker's Solver
+#define BATCH_BACKLOG    1024   // instances read ahead of the workers at most
+
+// Solves the instances of stdin onto stdout and returns once stdin is
+// drained. With an address (as in Distributed.h), serves one connection
+// after another instead, answering each on the same connection, and returns
+// only if the address cannot be listened at or accept fails.
+int runBatch( const char address[], int nThreads, const SolverOptions &options );
+
+#endif
@@ -0,0 +1,400 @@
+#include <iostream>  // cout
+#include <fstream>   // ifstream, ofstream
+#include <stdio.h>   // remove
+#include <string.h>  // strcmp
+#include <vector>    // vector
+#include <stdlib.h>  // rand, srand, atoi
+#include <math.h>    // sqrt
+#include <time.h>    // time
+#include <omp.h>     // OpenMP
+#include <algorithm> // sort
+#include "Timer.h"
+#include "Trip.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "EvalXOverMutate.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+/*
+ * The mutate of the original program: srand per thread and rand() shared by
+ * all threads. Kept here only as the "before" reference of the benchmark.
+ */
+void mutateRand( Trip offsprings[TOP_X] ) {
+  #pragma omp parallel
+  {
+    srand( time( NULL ) + omp_get_thread_num( ) );
+
+    #pragma omp for
+    for ( int i = 0; i < TOP_X; i++ ) {
+      if ( rand( ) % 100 < MUTATE_RATE ) {
+        int a = rand( ) % CITIES;
+        int b = rand( ) % CITIES;
+        while ( b == a ) b = rand( ) % CITIES;
+        char temp = offsprings[i].itinerary[a];
+        offsprings[i].itinerary[a] = offsprings[i].itinerary[b];
+        offsprings[i].itinerary[b] = temp;
+      }
+    }
+  }
+}
+
+/*
+ * The greedy crossover of the original program over n cities: successors are
+ * found by scanning the parent, and the fallback city by random retries.
+ * Kept here only as the "before" reference of the scaling benchmark.
+ */
+void greedyCrossoverScan( const int p1[], const int p2[], int child[], int n,
+                          const Distances &dist, Random &rng, vector<bool> &visited ) {
+  visited.assign( n, false );
+  child[0] = p1[0];
+  visited[child[0]] = true;
+  for ( int j = 1; j < n; j++ ) {
+    int city = child[j - 1], a = -1, b = -1;
+    for ( int k = 0; k < n; k++ )
+      if ( p1[k] == city ) { a = p1[( k + 1 ) % n]; break; }
+    for ( int k = 0; k < n; k++ )
+      if ( p2[k] == city ) { b = p2[( k + 1 ) % n]; break; }
+    if ( dist( city, a ) > dist( city, b ) ) {
+      int temp = a; a = b; b = temp;
+    }
+    if ( visited[a] ) a = b;
+    while ( visited[a] ) a = rng.nextInt( n );
+    visited[a] = true;
+    child[j] = a;
+  }
+}
+
+/*
+ * Times greedy crossover of random parents on a random n-city instance
+ */
+void crossoverScaling( int n ) {
+  Random rng( 7, n );
+  vector<int> xy( 2 * n );
+  for ( int i = 0; i < 2 * n; i++ )
+    xy[i] = rng.nextInt( 100000 );
+  Distances dist( n, ( const int (*)[2] )&xy[0] );
+
+  // about 2M generated cities per variant, at least 4 children
+  int pairs = 2000000 / n < 4 ? 4 : 2000000 / n;
+  vector<int> p1( n ), p2( n ), child( n );
+  for ( int c = 0; c < n; c++ )
+    p1[c] = p2[c] = c;
+  for ( int c = n - 1; c > 0; c-- ) {
+    swap( p1[c], p1[rng.nextInt( c + 1 )] );
+    swap( p2[c], p2[rng.nextInt( c + 1 )] );
+  }
+
+  Timer timer;
+  CrossoverBuffers buffers( n );
+  timer.start( );
+  for ( int i = 0; i < pairs; i++ )
+    greedyCrossover( &p1[0], &p2[0], &child[0], dist, rng, buffers );
+  double tables = ( double )timer.lap( ) / pairs;
+
+  // the quadratic reference is only run on a few children
+  int scanPairs = pairs > 2000 ? 2000 : pairs;
+  if ( n >= 5000 ) scanPairs = 4;
+  vector<bool> visited( n );
+  timer.start( );
+  for ( int i = 0; i < scanPairs; i++ )
+    greedyCrossoverScan( &p1[0], &p2[0], &child[0], n, dist, rng, visited );
+  double scan = ( double )timer.lap( ) / scanPairs;
+
+  cout << "crossover n=" << n << "\tscan " << scan << " usec/child\ttables "
+       << tables << " usec/child\t(" << tables * 1000 / n << " nsec/city)" << endl;
+}
+
+/*
+ * One layout of the distances of a random n-city instance: build time, size,
+ * a random lookup, and a greedy crossover child, whose lookups are mostly
+ * between cities adjacent in the parents
+ */
+void distanceLayout( int n, DistanceLayout layout ) {
+  static const char *names[] = { "auto", "float", "uint16", "on the fly" };
+  Random rng( 13, n );
+  vector<int> xy( 2 * n );
+  for ( int i = 0; i < 2 * n; i++ )
+    xy[i] = rng.nextInt( 100000 );
+
+  Timer timer;
+  timer.start( );
+  Distances dist( n, ( const int (*)[2] )&xy[0], false, layout );
+  long build = timer.lap( );
+
+  int lookups = 1 << 22;
+  vector<int> pairs( 2 * lookups );
+  for ( size_t i = 0; i < pairs.size( ); i++ )
+    pairs[i] = rng.nextInt( n );
+  float sum = 0;
+  timer.start( );
+  for ( int i = 0; i < lookups; i++ )
+    sum += dist( pairs[2 * i], pairs[2 * i + 1] );
+  double lookup = timer.lap( ) * 1000.0 / lookups;
+
+  vector<int> p1( n ), p2( n ), child( n );
+  for ( int c = 0; c < n; c++ )
+    p1[c] = p2[c] = c;
+  for ( int c = n - 1; c > 0; c-- ) {
+    swap( p1[c], p1[rng.nextInt( c + 1 )] );
+    swap( p2[c], p2[rng.nextInt( c + 1 )] );
+  }
+  int children = 2000000 / n < 4 ? 4 : 2000000 / n;
+  CrossoverBuffers buffers( n );
+  timer.start( );
+  for ( int i = 0; i < children; i++ )
+    greedyCrossover( &p1[0], &p2[0], &child[0], dist, rng, buffers );
+  double crossover = ( double )timer.lap( ) / children;
+
+  cout << n << "\t" << names[dist.layout] << "\t" << build << "\t" << dist.bytes( ) / 1024 << "\t"
+       << lookup << "\t" << crossover << ( sum < 0 ? "?" : "" ) << endl;
+}
+
+/*
+ * Times one child of operator op on random parents of a random n-city instance
+ */
+double crossoverTime( CrossoverOperator op, int n, int children ) {
+  Random rng( 11, n );
+  vector<int> xy( 2 * n );
+  for ( int i = 0; i < 2 * n; i++ )
+    xy[i] = rng.nextInt( 100000 );
+  Distances dist( n, ( const int (*)[2] )&xy[0] );
+  vector<int> p1( n ), p2( n ), child( n );
+  for ( int c = 0; c < n; c++ )
+    p1[c] = p2[c] = c;
+  for ( int c = n - 1; c > 0; c-- ) {
+    swap( p1[c], p1[rng.nextInt( c + 1 )] );
+    swap( p2[c], p2[rng.nextInt( c + 1 )] );
+  }
+
+  CrossoverBuffers buffers( n );
+  Timer timer;
+  timer.start( );
+  for ( int i = 0; i < children; i++ )
+    crossoverChild( op, &p1[0], &p2[0], &child[0], dist, rng, buffers );
+  return ( double )timer.lap( ) / children;
+}
+
+/*
+ * Fills trip[] with random tours and coordinates[][] with random cities
+ */
+void randomInstance( Trip trip[], int n, int coordinates[CITIES][2], uint64_t seed ) {
+  Random rng( seed, 0 );
+  for ( int i = 0; i < CITIES; i++ ) {
+    coordinates[i][0] = rng.nextInt( 100 );
+    coordinates[i][1] = rng.nextInt( 100 );
+  }
+  for ( int i = 0; i < n; i++ ) {
+    for ( int c = 0; c < CITIES; c++ )
+      trip[i].itinerary[c] = ( c < 26 ) ? c + 'A' : c - 26 + '0';
+    for ( int c = CITIES - 1; c > 0; c-- ) {
+      int r = rng.nextInt( c + 1 );
+      char temp = trip[i].itinerary[c];
+      trip[i].itinerary[c] = trip[i].itinerary[r];
+      trip[i].itinerary[r] = temp;
+    }
+    trip[i].itinerary[CITIES] = 0;
+    trip[i].fitness = 0.0;
+    trip[i].dirty = true;
+  }
+}
+
+bool shorterTrip( const Trip &a, const Trip &b ) {
+  return a.fitness < b.fitness;
+}
+
+/*
+ * A generation of n chromosomes, before and after the zero-copy population:
+ * the old loop sorted the Trip structs, copied the top half out to parents[]
+ * and the offsprings[] back in; now the ranking sorts slot indices and the
+ * offsprings are written straight into the slots they replace.
+ */
+void populationTraffic( int n, int reps, int coordinates[CITIES][2] ) {
+  int nTop = n / 2;
+  Trip *trip = new Trip[n];
+  Trip *arena = new Trip[2 * nTop];   // old parents[] followed by offsprings[]
+  vector<int> first( nTop ), second( nTop );
+  for ( int i = 0; i < nTop; i++ ) {
+    first[i] = i;
+    second[i] = nTop + i;
+  }
+  Ranking ranking( n );
+  Timer timer, phase;
+  long rankTime = 0, copyTime = 0, total;
+
+  // before: sort + select + populate copies around the same operators
+  randomInstance( trip, n, coordinates, 5 );
+  Distances dist( CITIES, coordinates, true );
+  evaluate( trip, ranking, dist );
+  timer.start( );
+  for ( int r = 0; r < reps; r++ ) {
+    phase.start( );
+    sort( trip, trip + n, shorterTrip );
+    rankTime += phase.lap( );
+    phase.start( );
+    for ( int i = 0; i < nTop; i++ )
+      arena[i] = trip[i];
+    copyTime += phase.lap( );
+    crossover( arena, &first[0], &second[0], dist, Random::derive( 5, 2 * r ), XOVER_GREEDY, nTop );
+    mutate( arena, &second[0], dist, Random::derive( 5, 2 * r + 1 ), nTop );
+    phase.start( );
+    for ( int i = 0; i < nTop; i++ )
+      trip[n - nTop + i] = arena[nTop + i];
+    copyTime += phase.lap( );
+  }
+  total = timer.lap( );
+  cout << n << "	copy	" << total / reps << "	" << rankTime / reps << "	" << copyTime / reps
+       << "	" << 2L * nTop * sizeof( Trip ) << " + sort" << endl;
+
+  // after: rank indices, operators in place
+  randomInstance( trip, n, coordinates, 5 );
+  evaluate( trip, ranking, dist );
+  rankTime = 0;
+  timer.start( );
+  for ( int r = 0; r < reps; r++ ) {
+    phase.start( );
+    evaluate( trip, ranking, dist );
+    rankTime += phase.lap( );
+    crossover( trip, ranking.parents( ), ranking.children( nTop ), dist,
+               Random::derive( 5, 2 * r ), XOVER_GREEDY, nTop );
+    mutate( trip, ranking.children( nTop ), dist, Random::derive( 5, 2 * r + 1 ), nTop );
+  }
+  total = timer.lap( );
+  cout << n << "	in place	" << total / reps << "	" << rankTime / reps << "	0	0" << endl;
+
+  delete[] trip;
+  delete[] arena;
+}
+
+/*
+ * Start-up cost of n chromosomes: parsing chromosome.txt with ifstream >>, as
+ * Tsp used to, against mapping the same trips from a binary snapshot
+ */
+void snapshotLoad( int n, int coordinates[CITIES][2] ) {
+  const char text[] = "bench_chromosome.txt", binary[] = "bench_chromosome.bin";
+  Trip *trip = new Trip[n];
+  Trip *loaded = new Trip[n];
+  randomInstance( trip, n, coordinates, 7 );
+  ofstream text_file( text );
+  for ( int i = 0; i < n; i++ )
+    text_file << trip[i].itinerary << endl;
+  text_file.close( );
+  saveSnapshot( binary, trip, n, coordinates, 7, 0 );
+
+  Timer timer;
+  timer.start( );
+  ifstream chromosome_file( text );
+  for ( int i = 0; i < n; i++ ) {
+    chromosome_file >> loaded[i].itinerary;
+    loaded[i].fitness = 0.0;
+    loaded[i].dirty = true;
+  }
+  chromosome_file.close( );
+  long textTime = timer.lap( );
+
+  uint64_t seed;
+  int generation;
+  timer.start( );
+  bool ok = loadSnapshot( binary, loaded, n, coordinates, seed, generation );
+  long binaryTime = timer.lap( );
+  for ( int i = 0; ok && i < n; i++ )
+    ok = strcmp( loaded[i].itinerary, trip[i].itinerary ) == 0 && loaded[i].dirty;
+
+  cout << "load n=" << n << "\ttext " << textTime << " usec\tsnapshot " << binaryTime << " usec\t"
+       << ( ok ? "same trips" : "MISMATCH" ) << endl;
+  remove( text );
+  remove( binary );
+  delete[] trip;
+  delete[] loaded;
+}
+
+/*
+ * Prints one result line: total time and offsprings per second
+ */
+void report( const char name[], long usec, int reps ) {
+  cout << name << "\t" << usec / reps << " usec/generation\t"
+       << ( long )( ( double )TOP_X * reps * 1000000.0 / ( usec > 0 ? usec : 1 ) )
+       << " offsprings/sec" << endl;
+}
+
+/*
+ * MAIN: usage: Bench #threads [reps]
+ */
+int main( int argc, char* argv[] ) {
+  int nThreads = ( argc >= 2 ) ? atoi( argv[1] ) : 1;
+  int reps = ( argc >= 3 ) ? atoi( argv[2] ) : 100;
+  omp_set_num_threads( nThreads );
+  cout << "# threads = " << nThreads << ", reps = " << reps << endl;
+
+  Trip *trip = new Trip[CHROMOSOMES];
+  int coordinates[CITIES][2];
+  randomInstance( trip, CHROMOSOMES, coordinates, 1 );
+  Distances distances( CITIES, coordinates, true );
+  Ranking ranking( CHROMOSOMES );
+  evaluate( trip, ranking, distances );
+
+  Timer timer;
+
+  timer.start( );
+  for ( int r = 0; r < reps; r++ )
+    crossover( trip, ranking.parents( ), ranking.children( TOP_X ), distances,
+               Random::derive( 1, r ), XOVER_GREEDY );
+  report( "crossover", timer.lap( ), reps );
+
+  Trip *offsprings = trip + CHROMOSOMES - TOP_X;
+  timer.start( );
+  for ( int r = 0; r < reps; r++ )
+    mutateRand( offsprings );
+  report( "mutate (rand)", timer.lap( ), reps );
+
+  timer.start( );
+  for ( int r = 0; r < reps; r++ )
+    mutate( trip, ranking.children( TOP_X ), distances, Random::derive( 1, r ) );
+  report( "mutate", timer.lap( ), reps );
+
+  // population bookkeeping: usec/generation in total, of it ranking and
+  // copying, and the Trip bytes copied per generation
+  cout << "chromosomes	population	usec/generation	rank usec	copy usec	bytes copied" << endl;
+  populationTraffic( CHROMOSOMES, 20, coordinates );
+  populationTraffic( 1000000, 5, coordinates );
+
+  // start-up: text population against a binary snapshot
+  snapshotLoad( 1000000, coordinates );
+
+  // distance provider layouts across instance sizes
+  cout << "cities\tdistances\tbuild usec\tKB\tnsec/lookup\tusec/greedy child" << endl;
+  int instances[] = { CITIES, 500, 2000, 5000, 20000 };
+  for ( int i = 0; i < 5; i++ )
+    for ( int layout = DIST_FLOAT; layout <= DIST_ON_THE_FLY; layout++ )
+      if ( layout == DIST_ON_THE_FLY || instances[i] <= 5000 )
+        distanceLayout( instances[i], ( DistanceLayout )layout );
+
+  // single-threaded scaling of the greedy crossover kernel in tour length
+  int sizes[] = { CITIES, 500, 5000 };
+  for ( int i = 0; i < 3; i++ )
+    crossoverScaling( sizes[i] );
+
+  // tour length against wall time per operator: a full MAX_GENERATION run of
+  // the GA on the same random population, plus the kernel cost per child
+  cout << "operator\tbest distance\tGA usec\tusec/child n=" << CITIES
+       << "\tusec/child n=500" << endl;
+  for ( int op = 0; op < XOVER_COUNT; op++ ) {
+    randomInstance( trip, CHROMOSOMES, coordinates, 3 );
+    Distances dist( CITIES, coordinates, true );
+    timer.start( );
+    for ( int generation = 0; generation < MAX_GENERATION; generation++ ) {
+      evaluate( trip, ranking, dist );
+      crossover( trip, ranking.parents( ), ranking.children( TOP_X ), dist,
+                 Random::derive( 3, 2 * generation ), ( CrossoverOperator )op );
+      mutate( trip, ranking.children( TOP_X ), dist, Random::derive( 3, 2 * generation + 1 ) );
+    }
+    evaluate( trip, ranking, dist );
+    long usec = timer.lap( );
+    cout << crossoverNames[op] << "\t" << trip[ranking.order[0]].fitness << "\t" << usec << "\t"
+         << crossoverTime( ( CrossoverOperator )op, CITIES, 100000 ) << "\t"
+         << crossoverTime( ( CrossoverOperator )op, 500, 200 ) << endl;
+  }
+  delete[] trip;
+  return 0;
+}
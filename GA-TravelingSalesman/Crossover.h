@@ -0,0 +1,431 @@
+#ifndef _CROSSOVER_H_
+#define _CROSSOVER_H_
+
+#include <vector>
+#include <string.h>
+#include "Random.h"
+
+using namespace std;
+
+// Crossover kernels over tours of n cities given as city indices 0..n-1.
+// They are independent of Trip/CITIES so that the same code runs the 36-city
+// GA and larger instances.
+//
+// Every operator writes one child from ( p1, p2 ) and works only in the
+// CrossoverBuffers of its thread, so no operator allocates per child.
+
+// Available recombination operators
+enum CrossoverOperator {
+  XOVER_GREEDY,  // greedy successor crossover
+  XOVER_OX,      // ordered crossover
+  XOVER_PMX,     // partially mapped crossover
+  XOVER_ERX,     // edge recombination
+  XOVER_EAX,     // edge assembly crossover with a single AB-cycle
+  XOVER_COUNT
+};
+
+static const char* const crossoverNames[XOVER_COUNT] = { "greedy", "ox", "pmx", "erx", "eax" };
+
+// Returns the operator called name, or XOVER_COUNT if there is none
+inline CrossoverOperator parseCrossover( const char name[] ) {
+  int op = 0;
+  while ( op < XOVER_COUNT && strcmp( name, crossoverNames[op] ) != 0 )
+    op++;
+  return ( CrossoverOperator )op;
+}
+
+// Scratch tables of one thread, allocated once for n cities and reused for
+// every pair of parents.
+class CrossoverBuffers {
+public:
+  CrossoverBuffers( int n ) : n( n ), succ1( n ), succ2( n ), unvisited( n ), where( n ),
+                              mark( n ), adj( 4 * n ), deg( n ), link( 2 * n ),
+                              path( 2 * n + 1 ), seen( 2 * n ), comp( n ) { }
+
+  // Fits the tables to n cities; they only reallocate when n exceeds any earlier n
+  void resize( int n ) {
+    this->n = n;
+    succ1.resize( n ); succ2.resize( n ); unvisited.resize( n ); where.resize( n );
+    mark.resize( n ); adj.resize( 4 * n ); deg.resize( n ); link.resize( 2 * n );
+    path.resize( 2 * n + 1 ); seen.resize( 2 * n ); comp.resize( n );
+  }
+
+  int n;
+  vector<int> succ1;      // succ1[c] = the city after c in parent 1
+  vector<int> succ2;      // succ2[c] = the city after c in parent 2
+  vector<int> unvisited;  // unvisited[0..count) = cities not yet in the child
+  vector<int> where;      // where[c] = position of c in unvisited (>= count once visited)
+  vector<char> mark;      // OX/PMX: city is in the copied segment
+  vector<int> adj;        // ERX edge table / EAX unused edges, 4 slots per city
+  vector<int> deg;        // # entries of adj in use per city
+  vector<int> link;       // EAX: the child's two neighbours per city
+  vector<int> path;       // EAX: alternating walk
+  vector<int> seen;       // EAX: last walk position of a city, per parity
+  vector<int> comp;       // EAX: subtour id of each city
+};
+
+/*
+ * Greedy crossover: starting from parent 1's first city, the child always
+ * moves to the nearer one of the two parents' successors of its current city.
+ * When both are already visited, a random unvisited city is taken instead.
+ *
+ * Successors come from per-pair tables and the unvisited cities are kept in a
+ * swap-remove list, so each step is O(1) and a child costs O(n).
+ *
+ * @param dist: distance functor, dist( a, b ) for city indices a and b
+ */
+template <class Distance>
+void greedyCrossover( const int p1[], const int p2[], int child[],
+                      const Distance &dist, Random &rng, CrossoverBuffers &buf ) {
+  int n = buf.n;
+  int *succ1 = &buf.succ1[0], *succ2 = &buf.succ2[0];
+  int *unvisited = &buf.unvisited[0], *where = &buf.where[0];
+
+  for ( int k = 0; k < n - 1; k++ ) {
+    succ1[p1[k]] = p1[k + 1];
+    succ2[p2[k]] = p2[k + 1];
+  }
+  succ1[p1[n - 1]] = p1[0];
+  succ2[p2[n - 1]] = p2[0];
+
+  for ( int c = 0; c < n; c++ )
+    unvisited[c] = where[c] = c;
+  int count = n;
+
+  int city = p1[0];
+  for ( int j = 0; ; j++ ) {
+    // mark city visited: swap it with the last unvisited one
+    int last = unvisited[--count];
+    unvisited[where[city]] = last;
+    where[last] = where[city];
+    where[city] = count;
+
+    child[j] = city;
+    if ( j == n - 1 )
+      break;
+
+    int a = succ1[city], b = succ2[city];
+    if ( dist( city, a ) > dist( city, b ) ) {
+      int temp = a; a = b; b = temp;
+    }
+    if ( where[a] < count )
+      city = a;
+    else if ( where[b] < count )
+      city = b;
+    else
+      city = unvisited[rng.nextInt( count )];
+  }
+}
+
+/*
+ * Ordered crossover (OX): the child keeps a random segment of parent 1 in
+ * place and fills the remaining positions, after the segment, with the other
+ * cities in the order they follow the segment in parent 2.
+ */
+inline void orderedCrossover( const int p1[], const int p2[], int child[],
+                              Random &rng, CrossoverBuffers &buf ) {
+  int n = buf.n;
+  char *mark = &buf.mark[0];
+  int a = rng.nextInt( n ), b = rng.nextInt( n );
+  if ( a > b ) {
+    int temp = a; a = b; b = temp;
+  }
+
+  for ( int c = 0; c < n; c++ )
+    mark[c] = 0;
+  for ( int i = a; i <= b; i++ ) {
+    child[i] = p1[i];
+    mark[p1[i]] = 1;
+  }
+
+  int k = ( b + 1 ) % n;
+  for ( int i = 0, j = ( b + 1 ) % n; i < n; i++, j = ( j + 1 == n ) ? 0 : j + 1 )
+    if ( !mark[p2[j]] ) {
+      child[k] = p2[j];
+      k = ( k + 1 == n ) ? 0 : k + 1;
+    }
+}
+
+/*
+ * Partially mapped crossover (PMX): the child takes a random segment of
+ * parent 1 and every other position from parent 2, where a city already in
+ * the segment is replaced through the segment's p1 <-> p2 mapping.
+ */
+inline void pmxCrossover( const int p1[], const int p2[], int child[],
+                          Random &rng, CrossoverBuffers &buf ) {
+  int n = buf.n;
+  char *mark = &buf.mark[0];
+  int *pos1 = &buf.where[0];   // position of a segment city in parent 1
+  int a = rng.nextInt( n ), b = rng.nextInt( n );
+  if ( a > b ) {
+    int temp = a; a = b; b = temp;
+  }
+
+  for ( int c = 0; c < n; c++ )
+    mark[c] = 0;
+  for ( int i = a; i <= b; i++ ) {
+    child[i] = p1[i];
+    mark[p1[i]] = 1;
+    pos1[p1[i]] = i;
+  }
+
+  for ( int i = 0; i < n; i++ ) {
+    if ( i == a ) {
+      i = b;
+      continue;
+    }
+    int c = p2[i];
+    while ( mark[c] )
+      c = p2[pos1[c]];
+    child[i] = c;
+  }
+}
+
+/*
+ * Edge recombination (ERX): the child is grown from parent 1's first city
+ * along the union of both parents' edges, always moving to the neighbour
+ * with the fewest remaining edges (the nearer one on ties). A dead end
+ * continues from a random unvisited city.
+ */
+template <class Distance>
+void edgeRecombination( const int p1[], const int p2[], int child[],
+                        const Distance &dist, Random &rng, CrossoverBuffers &buf ) {
+  int n = buf.n;
+  int *adj = &buf.adj[0], *deg = &buf.deg[0];
+  int *unvisited = &buf.unvisited[0], *where = &buf.where[0];
+
+  // edge table: up to 4 distinct neighbours per city
+  for ( int c = 0; c < n; c++ ) {
+    deg[c] = 0;
+    unvisited[c] = where[c] = c;
+  }
+  const int *parent[2] = { p1, p2 };
+  for ( int p = 0; p < 2; p++ )
+    for ( int i = 0; i < n; i++ ) {
+      int u = parent[p][i], v = parent[p][i + 1 == n ? 0 : i + 1];
+      bool known = false;
+      for ( int k = 0; k < deg[u]; k++ )
+        known |= ( adj[4 * u + k] == v );
+      if ( !known ) {
+        adj[4 * u + deg[u]++] = v;
+        adj[4 * v + deg[v]++] = u;
+      }
+    }
+  int count = n;
+
+  int city = p1[0];
+  for ( int j = 0; ; j++ ) {
+    int last = unvisited[--count];
+    unvisited[where[city]] = last;
+    where[last] = where[city];
+    where[city] = count;
+
+    // drop city from the edge lists of its neighbours
+    for ( int k = 0; k < deg[city]; k++ ) {
+      int x = adj[4 * city + k];
+      for ( int m = 0; m < deg[x]; m++ )
+        if ( adj[4 * x + m] == city ) {
+          adj[4 * x + m] = adj[4 * x + --deg[x]];
+          break;
+        }
+    }
+
+    child[j] = city;
+    if ( j == n - 1 )
+      break;
+
+    int next = -1;
+    for ( int k = 0; k < deg[city]; k++ ) {
+      int x = adj[4 * city + k];
+      if ( next < 0 || deg[x] < deg[next] ||
+           ( deg[x] == deg[next] && dist( city, x ) < dist( city, next ) ) )
+        next = x;
+    }
+    city = ( next >= 0 ) ? next : unvisited[rng.nextInt( count )];
+  }
+}
+
+/*
+ * EAX-lite: edge assembly crossover with one AB-cycle.
+ *
+ * Starting from a random city, an alternating walk over the edges that are
+ * in exactly one parent (p1 edge, p2 edge, p1 edge, ...) is followed until it
+ * closes an AB-cycle. The child is parent 1 with the cycle's p1 edges
+ * replaced by its p2 edges. That splits it into subtours, which are then
+ * joined, smallest first, by the cheapest 2-edge exchange with another
+ * subtour.
+ */
+template <class Distance>
+void eaxCrossover( const int p1[], const int p2[], int child[],
+                   const Distance &dist, Random &rng, CrossoverBuffers &buf ) {
+  int n = buf.n;
+  int *link = &buf.link[0], *path = &buf.path[0], *seen = &buf.seen[0], *comp = &buf.comp[0];
+  int *rest = &buf.adj[0], *nRest = &buf.deg[0];  // unused p1 edges in slots 0-1, p2 edges in 2-3
+  int *size = &buf.where[0];                      // # cities of each subtour
+
+  // child starts as parent 1
+  for ( int i = 0; i < n; i++ ) {
+    int u = p1[i];
+    link[2 * u] = p1[i == 0 ? n - 1 : i - 1];
+    link[2 * u + 1] = p1[i + 1 == n ? 0 : i + 1];
+  }
+
+  // the edges in only one of the parents
+  for ( int c = 0; c < n; c++ ) {
+    nRest[c] = 0;
+    seen[2 * c] = seen[2 * c + 1] = -1;
+  }
+  for ( int i = 0; i < n; i++ ) {
+    int u = p2[i], prev = p2[i == 0 ? n - 1 : i - 1], next = p2[i + 1 == n ? 0 : i + 1];
+    for ( int k = 0; k < 2; k++ ) {
+      int v = link[2 * u + k];
+      if ( v != prev && v != next )
+        rest[4 * u + ( nRest[u] & 3 )] = v, nRest[u] += 1;        // p1 edge, low count
+      int w = ( k == 0 ) ? prev : next;
+      if ( w != link[2 * u] && w != link[2 * u + 1] )
+        rest[4 * u + 2 + ( nRest[u] >> 2 )] = w, nRest[u] += 4;   // p2 edge, high count
+    }
+  }
+
+  // find a start city with an unused p1 edge; identical parents have none
+  int start = rng.nextInt( n ), tries = 0;
+  while ( ( nRest[start] & 3 ) == 0 && tries++ < n )
+    start = ( start + 1 == n ) ? 0 : start + 1;
+  if ( tries > n ) {
+    for ( int i = 0; i < n; i++ )
+      child[i] = p1[i];
+    return;
+  }
+
+  // alternating walk until it revisits a city at the same parity
+  int len = 0, from = -1, city = start;
+  while ( true ) {
+    int parity = len & 1;
+    if ( seen[2 * city + parity] >= 0 ) {
+      from = seen[2 * city + parity];
+      break;
+    }
+    seen[2 * city + parity] = len;
+    path[len++] = city;
+
+    // even steps take a p1 edge, odd steps a p2 edge; consume it at both ends
+    int base = parity ? 2 : 0, shift = parity ? 2 : 0;
+    int count = ( nRest[city] >> shift ) & 3;
+    if ( count == 0 || len > 2 * n )
+      break;                                    // cannot happen on valid tours
+    int pick = rng.nextInt( count );
+    int next = rest[4 * city + base + pick];
+    rest[4 * city + base + pick] = rest[4 * city + base + count - 1];
+    nRest[city] -= 1 << shift;
+    int countNext = ( nRest[next] >> shift ) & 3;
+    for ( int k = 0; k < countNext; k++ )
+      if ( rest[4 * next + base + k] == city ) {
+        rest[4 * next + base + k] = rest[4 * next + base + countNext - 1];
+        nRest[next] -= 1 << shift;
+        break;
+      }
+    city = next;
+  }
+  if ( from < 0 ) {
+    for ( int i = 0; i < n; i++ )
+      child[i] = p1[i];
+    return;
+  }
+  path[len] = city;
+
+  // apply the AB-cycle path[from..len]: drop its p1 edges, then add its p2
+  // edges. The walk took p1 edges from even positions whatever the parity
+  // the cycle closed at, so the roles go by the parity of i, not of from.
+  int firstP1 = from + ( from & 1 ), firstP2 = from + 1 - ( from & 1 );
+  for ( int i = firstP1; i < len; i += 2 ) {
+    int u = path[i], v = path[i + 1];
+    link[2 * u + ( link[2 * u] == v ? 0 : 1 )] = -1;
+    link[2 * v + ( link[2 * v] == u ? 0 : 1 )] = -1;
+  }
+  for ( int i = firstP2; i < len; i += 2 ) {
+    int u = path[i], v = path[i + 1];
+    link[2 * u + ( link[2 * u] < 0 ? 0 : 1 )] = v;
+    link[2 * v + ( link[2 * v] < 0 ? 0 : 1 )] = u;
+  }
+
+  // join subtours until one tour is left
+  while ( true ) {
+    int nComp = 0;
+    for ( int c = 0; c < n; c++ )
+      comp[c] = -1;
+    for ( int c = 0; c < n; c++ ) {
+      if ( comp[c] >= 0 )
+        continue;
+      size[nComp] = 0;
+      for ( int prev = -1, u = c; comp[u] < 0; ) {
+        comp[u] = nComp;
+        size[nComp]++;
+        int next = ( link[2 * u] != prev ) ? link[2 * u] : link[2 * u + 1];
+        prev = u;
+        u = next;
+      }
+      nComp++;
+    }
+    if ( nComp == 1 )
+      break;
+
+    int smallest = 0;
+    for ( int k = 1; k < nComp; k++ )
+      if ( size[k] < size[smallest] )
+        smallest = k;
+
+    // cheapest exchange of an edge (u, v) inside and (w, x) outside
+    // for (u, w) and (v, x)
+    float best = 0;
+    int bu = -1, bv = -1, bw = -1, bx = -1;
+    for ( int u = 0; u < n; u++ ) {
+      if ( comp[u] != smallest )
+        continue;
+      for ( int k = 0; k < 2; k++ ) {
+        int v = link[2 * u + k];
+        float duv = dist( u, v );
+        for ( int w = 0; w < n; w++ ) {
+          if ( comp[w] == smallest )
+            continue;
+          for ( int m = 0; m < 2; m++ ) {
+            int x = link[2 * w + m];
+            float delta = dist( u, w ) + dist( v, x ) - duv - dist( w, x );
+            if ( bu < 0 || delta < best ) {
+              best = delta;
+              bu = u; bv = v; bw = w; bx = x;
+            }
+          }
+        }
+      }
+    }
+    link[2 * bu + ( link[2 * bu] == bv ? 0 : 1 )] = bw;
+    link[2 * bv + ( link[2 * bv] == bu ? 0 : 1 )] = bx;
+    link[2 * bw + ( link[2 * bw] == bx ? 0 : 1 )] = bu;
+    link[2 * bx + ( link[2 * bx] == bw ? 0 : 1 )] = bv;
+  }
+
+  // read the tour out, from parent 1's first city
+  for ( int j = 0, prev = -1, u = p1[0]; j < n; j++ ) {
+    child[j] = u;
+    int next = ( link[2 * u] != prev ) ? link[2 * u] : link[2 * u + 1];
+    prev = u;
+    u = next;
+  }
+}
+
+/*
+ * Writes one child of ( p1, p2 ) with operator op
+ */
+template <class Distance>
+void crossoverChild( CrossoverOperator op, const int p1[], const int p2[], int child[],
+                     const Distance &dist, Random &rng, CrossoverBuffers &buf ) {
+  switch ( op ) {
+  case XOVER_OX:  orderedCrossover( p1, p2, child, rng, buf ); break;
+  case XOVER_PMX: pmxCrossover( p1, p2, child, rng, buf ); break;
+  case XOVER_ERX: edgeRecombination( p1, p2, child, dist, rng, buf ); break;
+  case XOVER_EAX: eaxCrossover( p1, p2, child, dist, rng, buf ); break;
+  default:        greedyCrossover( p1, p2, child, dist, rng, buf ); break;
+  }
+}
+
+#endif
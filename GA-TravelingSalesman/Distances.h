@@ -0,0 +1,100 @@
+#ifndef _DISTANCES_H_
+#define _DISTANCES_H_
+
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+
+using namespace std;
+
+// Distances between the nodes of one instance, built once and then shared
+// read-only by every operator and thread. Node i is at coordinates[i]; with
+// origin, node n is the (0, 0) all trips start from.
+//
+// Small instances keep the lower triangle of the symmetric matrix, as floats
+// or, on request, as 16-bit fixed point at half the size. Large instances
+// compute each distance from the coordinates, which stay in cache long after
+// a matrix of the same instance would not: past a few MB of triangle (about
+// 1000 nodes) a lookup is a cache miss and costs more than a sqrtf.
+
+#define DIST_TRIANGLE_MAX 1024   // nodes up to which DIST_AUTO keeps the float triangle (2 MB)
+
+enum DistanceLayout { DIST_AUTO, DIST_FLOAT, DIST_UINT16, DIST_ON_THE_FLY };
+
+class Distances {
+public:
+  template <class Coordinate>
+  Distances( int n, const Coordinate coordinates[][2], bool origin = false, DistanceLayout layout = DIST_AUTO )
+    : n( origin ? n + 1 : n ), layout( layout ), xy( 2 * this->n, 0.0f ), scale( 1.0f ) {
+    for ( int i = 0; i < n; i++ ) {
+      xy[2 * i] = coordinates[i][0];
+      xy[2 * i + 1] = coordinates[i][1];
+    }
+    if ( layout == DIST_AUTO )
+      this->layout = ( this->n <= DIST_TRIANGLE_MAX ) ? DIST_FLOAT : DIST_ON_THE_FLY;
+    if ( this->layout == DIST_ON_THE_FLY )
+      return;
+
+    size_t size = ( size_t )this->n * ( this->n + 1 ) / 2;
+    if ( this->layout == DIST_FLOAT ) {
+      triangle.resize( size );
+      #pragma omp parallel for schedule( dynamic, 16 )
+      for ( int a = 0; a < this->n; a++ )
+        for ( int b = 0; b <= a; b++ )
+          triangle[index( a, b )] = exact( a, b );
+    } else {
+      double longest = 0;
+      for ( int a = 0; a < this->n; a++ )
+        for ( int b = 0; b < a; b++ ) {
+          double d = exact( a, b );
+          longest = ( d > longest ) ? d : longest;
+        }
+      scale = ( longest > 0 ) ? longest / 65535 : 1.0f;
+      fixed.resize( size );
+      #pragma omp parallel for schedule( dynamic, 16 )
+      for ( int a = 0; a < this->n; a++ )
+        for ( int b = 0; b <= a; b++ )
+          fixed[index( a, b )] = ( uint16_t )( exact( a, b ) / scale + 0.5 );
+    }
+  }
+
+  float operator()( int a, int b ) const {
+    switch ( layout ) {
+    case DIST_FLOAT:
+      return triangle[index( a, b )];
+    case DIST_UINT16:
+      return fixed[index( a, b )] * scale;
+    default: {
+      float dx = xy[2 * a] - xy[2 * b], dy = xy[2 * a + 1] - xy[2 * b + 1];
+      return sqrtf( dx * dx + dy * dy );
+    }
+    }
+  }
+
+  // Bytes held for lookups
+  size_t bytes( ) const {
+    return xy.size( ) * sizeof( float ) + triangle.size( ) * sizeof( float ) + fixed.size( ) * sizeof( uint16_t );
+  }
+
+  int n;                   // # nodes, the origin included
+  DistanceLayout layout;   // never DIST_AUTO once built
+
+private:
+  vector<float> xy;        // node i at ( xy[2i], xy[2i + 1] )
+  vector<float> triangle;  // DIST_FLOAT: distance of a >= b at a (a + 1) / 2 + b
+  vector<uint16_t> fixed;  // DIST_UINT16: the same in units of scale
+  float scale;
+
+  size_t index( int a, int b ) const {
+    size_t hi = ( a >= b ) ? a : b, lo = ( a >= b ) ? b : a;
+    return hi * ( hi + 1 ) / 2 + lo;
+  }
+
+  // The distance as the original program computed it: in double, then rounded
+  float exact( int a, int b ) const {
+    double dx = xy[2 * a] - xy[2 * b], dy = xy[2 * a + 1] - xy[2 * b + 1];
+    return sqrt( dx * dx + dy * dy );
+  }
+};
+
+#endif
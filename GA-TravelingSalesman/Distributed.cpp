@@ -0,0 +1,335 @@
+#include <iostream>     // cout
+#include <vector>       // vector
+#include <string.h>     // memset, strncpy, strchr
+#include <stdlib.h>     // atoi
+#include <unistd.h>     // read, write, close, unlink, usleep
+#include <errno.h>      // errno
+#include <poll.h>       // poll
+#include <sys/socket.h> // socket, bind, listen, accept, connect
+#include <sys/un.h>     // sockaddr_un
+#include <netinet/in.h> // sockaddr_in
+#include <arpa/inet.h>  // htons, htonl
+#include "Timer.h"
+#include "Random.h"
+#include "Island.h"
+#include "Distributed.h"
+
+using namespace std;
+
+#define ACCEPT_TIMEOUT  30000  // msec to wait for all workers to connect
+#define CONNECT_RETRIES 100    // worker connection attempts, 100 msec apart
+
+// Message types
+enum { MSG_CONFIG, MSG_MIGRANTS, MSG_DONE };
+
+// Every message is this header followed by count packed trips
+struct MessageHeader {
+  uint8_t type;
+  uint8_t count;       // # packed trips that follow
+  uint16_t worker;     // sender (MIGRANTS, DONE) or receiver (CONFIG)
+  uint32_t generation; // generation of the sender (MIGRANTS)
+  uint64_t seed;       // master seed (CONFIG)
+  uint32_t nWorkers;   // # workers (CONFIG)
+  uint32_t unused;
+};
+
+// Reads / writes exactly len bytes; false on EOF or error
+static bool readAll( int fd, void *buf, size_t len ) {
+  char *p = ( char * )buf;
+  while ( len > 0 ) {
+    ssize_t r = read( fd, p, len );
+    if ( r < 0 && errno == EINTR )
+      continue;
+    if ( r <= 0 )
+      return false;
+    p += r;
+    len -= r;
+  }
+  return true;
+}
+
+static bool writeAll( int fd, const void *buf, size_t len ) {
+  const char *p = ( const char * )buf;
+  while ( len > 0 ) {
+    ssize_t w = send( fd, p, len, MSG_NOSIGNAL );   // no SIGPIPE from a dead peer
+    if ( w < 0 && errno == EINTR )
+      continue;
+    if ( w <= 0 )
+      return false;
+    p += w;
+    len -= w;
+  }
+  return true;
+}
+
+// Sends a header and count trips in one write
+static bool sendTrips( int fd, MessageHeader header, const Trip trips[], int count ) {
+  vector<unsigned char> buf( sizeof( header ) + count * PACKED_TRIP );
+  header.count = count;
+  memcpy( &buf[0], &header, sizeof( header ) );
+  for ( int i = 0; i < count; i++ )
+    packTrip( trips[i], &buf[sizeof( header ) + i * PACKED_TRIP] );
+  return writeAll( fd, &buf[0], buf.size( ) );
+}
+
+// Receives a header and its trips (at most 255); with no trips[] to fill,
+// a message carrying trips is refused
+static bool receiveTrips( int fd, MessageHeader &header, Trip trips[] ) {
+  if ( !readAll( fd, &header, sizeof( header ) ) )
+    return false;
+  if ( trips == NULL && header.count != 0 )
+    return false;
+  unsigned char packed[PACKED_TRIP];
+  for ( int i = 0; i < header.count; i++ ) {
+    if ( !readAll( fd, packed, PACKED_TRIP ) )
+      return false;
+    unpackTrip( packed, trips[i] );
+  }
+  return true;
+}
+
+int openSocket( const char address[], bool listening ) {
+  const char *colon = strchr( address, ':' );
+  int fd = socket( colon ? AF_INET : AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 )
+    return -1;
+
+  struct sockaddr_un local;
+  struct sockaddr_in inet;
+  struct sockaddr *addr;
+  socklen_t len;
+  if ( colon ) {
+    memset( &inet, 0, sizeof( inet ) );
+    inet.sin_family = AF_INET;
+    inet.sin_port = htons( atoi( colon + 1 ) );
+    inet.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    addr = ( struct sockaddr * )&inet;
+    len = sizeof( inet );
+  } else {
+    memset( &local, 0, sizeof( local ) );
+    local.sun_family = AF_UNIX;
+    strncpy( local.sun_path, address, sizeof( local.sun_path ) - 1 );
+    addr = ( struct sockaddr * )&local;
+    len = sizeof( local );
+  }
+
+  if ( listening ) {
+    int on = 1;
+    setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) );
+    if ( !colon )
+      unlink( address );
+    if ( bind( fd, addr, len ) < 0 || listen( fd, 64 ) < 0 ) {
+      close( fd );
+      return -1;
+    }
+    return fd;
+  }
+
+  // the coordinator may not be up yet
+  for ( int attempt = 0; attempt < CONNECT_RETRIES; attempt++ ) {
+    if ( connect( fd, addr, len ) == 0 )
+      return fd;
+    usleep( 100000 );
+  }
+  close( fd );
+  return -1;
+}
+
+/*
+ * Coordinator: accepts the workers, hands out worker ids and the seed, then
+ * forwards migrants along the ring of live workers until all are finished.
+ */
+int runCoordinator( const char address[], int nWorkers, uint64_t seed ) {
+  int listenFd = openSocket( address, true );
+  if ( listenFd < 0 ) {
+    cerr << "cannot listen on " << address << endl;
+    return -1;
+  }
+
+  // wait for the workers; start with those that showed up in time
+  vector<int> fds;
+  while ( ( int )fds.size( ) < nWorkers ) {
+    struct pollfd p = { listenFd, POLLIN, 0 };
+    if ( poll( &p, 1, ACCEPT_TIMEOUT ) <= 0 )
+      break;
+    int fd = accept( listenFd, NULL, NULL );
+    if ( fd >= 0 )
+      fds.push_back( fd );
+  }
+  close( listenFd );
+  if ( strchr( address, ':' ) == NULL )
+    unlink( address );
+  nWorkers = fds.size( );
+  cout << "# workers = " << nWorkers << endl;
+  if ( nWorkers == 0 )
+    return -1;
+
+  Timer timer;
+  timer.start( );
+
+  vector<bool> alive( nWorkers, true ), done( nWorkers, false );
+  for ( int w = 0; w < nWorkers; w++ ) {
+    MessageHeader config;
+    memset( &config, 0, sizeof( config ) );
+    config.type = MSG_CONFIG;
+    config.worker = w;
+    config.seed = seed;
+    config.nWorkers = nWorkers;
+    alive[w] = sendTrips( fds[w], config, NULL, 0 );
+  }
+
+  Trip shortest;
+  shortest.fitness = -1.0;
+  Trip trips[255];
+  while ( true ) {
+    // the workers still running are those alive and not done
+    vector<struct pollfd> polls;
+    vector<int> owner;
+    for ( int w = 0; w < nWorkers; w++ )
+      if ( alive[w] && !done[w] ) {
+        struct pollfd p = { fds[w], POLLIN, 0 };
+        polls.push_back( p );
+        owner.push_back( w );
+      }
+    if ( polls.empty( ) )
+      break;
+    if ( poll( &polls[0], polls.size( ), -1 ) < 0 && errno != EINTR )
+      break;
+
+    for ( size_t k = 0; k < polls.size( ); k++ ) {
+      int w = owner[k];
+      // a worker found dead while forwarding earlier in this round is gone
+      if ( polls[k].revents == 0 || !alive[w] || done[w] )
+        continue;
+      MessageHeader header;
+      if ( !receiveTrips( fds[w], header, trips ) ) {
+        cout << "worker " << w << " exited early" << endl;
+        alive[w] = false;
+        close( fds[w] );
+        continue;
+      }
+
+      // the first trip of a message is the sender's best
+      if ( header.count > 0 && ( shortest.fitness < 0 || trips[0].fitness < shortest.fitness ) ) {
+        shortest = trips[0];
+        cout << "worker " << w << " generation: " << header.generation
+             << " shortest distance = " << shortest.fitness
+             << "\t itinerary = " << shortest.itinerary << endl;
+      }
+
+      if ( header.type == MSG_DONE ) {
+        done[w] = true;
+        close( fds[w] );
+        continue;
+      }
+
+      // forward migrants to the next worker still running
+      for ( int step = 1; step < nWorkers; step++ ) {
+        int next = ( w + step ) % nWorkers;
+        if ( !alive[next] || done[next] )
+          continue;
+        if ( !sendTrips( fds[next], header, trips, header.count ) ) {
+          cout << "worker " << next << " exited early" << endl;
+          alive[next] = false;
+          close( fds[next] );
+          continue;
+        }
+        break;
+      }
+    }
+  }
+
+  long elapsed = timer.lap( );
+  int finished = 0;
+  for ( int w = 0; w < nWorkers; w++ )
+    finished += done[w];
+  cout << "workers finished = " << finished << " of " << nWorkers << endl;
+  if ( shortest.fitness >= 0 )
+    cout << "shortest distance = " << shortest.fitness
+         << "\t itinerary = " << shortest.itinerary << endl;
+  cout << "elapsed time = " << elapsed << endl;
+  cout << "generations/sec = " << MAX_GENERATION * 1000000.0 / elapsed << endl;
+  return finished > 0 ? 0 : -1;
+}
+
+// Worker side of the migration: elites go to the coordinator, migrants
+// forwarded by it come back. A lost coordinator turns this into a no-op and
+// the worker finishes on its own.
+class SocketMigration : public ExternalMigration {
+public:
+  SocketMigration( int fd, int worker ) : fd( fd ), worker( worker ), connected( true ) { }
+
+  void send( const Trip elites[], int count, int generation ) {
+    if ( !connected )
+      return;
+    MessageHeader header;
+    memset( &header, 0, sizeof( header ) );
+    header.type = MSG_MIGRANTS;
+    header.worker = worker;
+    header.generation = generation;
+    connected = sendTrips( fd, header, elites, count );
+  }
+
+  int receive( Trip migrants[], int max ) {
+    int count = 0;
+    Trip trips[255];
+    while ( connected ) {
+      struct pollfd p = { fd, POLLIN, 0 };
+      if ( poll( &p, 1, 0 ) <= 0 )
+        break;
+      MessageHeader header;
+      if ( !receiveTrips( fd, header, trips ) ) {
+        connected = false;
+        break;
+      }
+      for ( int i = 0; i < header.count && count < max; i++ )
+        migrants[count++] = trips[i];
+    }
+    return count;
+  }
+
+  int fd, worker;
+  bool connected;
+};
+
+/*
+ * Worker: gets its id from the coordinator, evolves
+ * trip[id * CHROMOSOMES / nWorkers .. (id + 1) * CHROMOSOMES / nWorkers)
+ * (the remainder shared one trip per worker, as islands share theirs) and
+ * reports its shortest trip when done.
+ */
+int runWorker( const char address[], Trip trip[CHROMOSOMES], const Distances &dist,
+               int nIslands, int nThreads, CrossoverOperator op, bool localSearch ) {
+  int fd = openSocket( address, false );
+  MessageHeader config;
+  if ( fd < 0 || !receiveTrips( fd, config, NULL ) || config.type != MSG_CONFIG ) {
+    cerr << "cannot reach the coordinator at " << address << endl;
+    if ( fd >= 0 )
+      close( fd );
+    return -1;
+  }
+
+  int worker = config.worker;
+  int first = ( long )worker * CHROMOSOMES / config.nWorkers;
+  int n = ( long )( worker + 1 ) * CHROMOSOMES / config.nWorkers - first;   // trips of this worker
+  cout << "worker " << worker << " of " << config.nWorkers << ", " << n << " trips" << endl;
+
+  SocketMigration migration( fd, worker );
+  Trip shortest;
+  evolveIslands( trip + first, n, dist, nIslands > 0 ? nIslands : 1, nThreads,
+                 Random::derive( config.seed, worker ), op, localSearch, shortest, &migration );
+
+  if ( migration.connected ) {
+    MessageHeader header;
+    memset( &header, 0, sizeof( header ) );
+    header.type = MSG_DONE;
+    header.worker = worker;
+    header.generation = MAX_GENERATION;
+    sendTrips( fd, header, &shortest, 1 );
+  }
+  close( fd );
+
+  cout << "worker " << worker << " shortest distance = " << shortest.fitness
+       << "\t itinerary = " << shortest.itinerary << endl;
+  return 0;
+}
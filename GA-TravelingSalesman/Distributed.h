@@ -0,0 +1,34 @@
+#ifndef _DISTRIBUTED_H_
+#define _DISTRIBUTED_H_
+
+#include <stdint.h>
+#include "Trip.h"
+#include "Crossover.h"
+#include "Distances.h"
+#include "Snapshot.h"
+
+// Coordinator / worker processes over a Unix-domain socket (a path) or
+// loopback TCP (":port").
+//
+// Each worker evolves its share CHROMOSOMES / # workers of the population as
+// islands (see Island.h) and sends the elites of its island 0 to the
+// coordinator every MIGRATION_INTERVAL generations. The coordinator forwards
+// them to the next live worker, keeps the shortest trip seen, and carries on
+// with the remaining workers when one exits early.
+
+// Trips travel packed as in snapshots (see Snapshot.h)
+
+// Opens a listening (coordinator) or connected (worker) stream socket at
+// address; -1 on failure
+int openSocket( const char address[], bool listening );
+
+// Waits for nWorkers workers at address, runs them to completion and prints
+// the shortest trip. Returns 0 if at least one worker finished.
+int runCoordinator( const char address[], int nWorkers, uint64_t seed );
+
+// Connects to the coordinator at address and evolves this worker's share of
+// trip[CHROMOSOMES] with nIslands islands and nThreads threads.
+int runWorker( const char address[], Trip trip[CHROMOSOMES], const Distances &dist,
+               int nIslands, int nThreads, CrossoverOperator op, bool localSearch );
+
+#endif
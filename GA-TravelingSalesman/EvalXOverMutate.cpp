@@ -1,85 +1,94 @@
 #include <iostream>  // cout
 #include <stdlib.h>  // rand
-#include <math.h>    // sqrt, pow
 #include <omp.h>     // OpenMP
-#include <string.h>  // memset
+#include <string.h>  // memset, memcpy
 #include <algorithm>
 #include "Timer.h"
 #include "Trip.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "EvalXOverMutate.h"
+#include "LocalSearch.h"
+#include "Distances.h"
+#include "Telemetry.h"
 
 #define CHROMOSOMES    50000 // 50000 different trips
 #define CITIES         36    // 36 cities = ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789
 #define TOP_X          25000 // top optimal 25%
-#define MUTATE_RATE    52    // optimal 50%
 
 using namespace std;
 
 // HELPERS FUNCTIONS
-bool CompareTrips(const Trip& a, const Trip& b) {
-   return a.fitness < b.fitness; 
-}
 
 int getIndex(char c){
    return ( c >= 'A' ) ? c - 'A' : c - '0' + 26;
 }
 
 char getCityCh(int index){
-   if(index >= 0 && index <= 26) return index+'A';
+   if(index >= 0 && index < 26) return index+'A';
    return index - 26 + '0';
 }
 
-char getRandomCity() {
-   char city = rand() % CITIES;
-   if ( city < 26 ) return city + 'A';
-   return city - 26 + '0';
-}
+// A trip is an open path from (0, 0): as a closed tour it runs
+// ORIGIN -> cities -> OPEN_END -> ORIGIN, where OPEN_END is 0 away from every
+// city and the OPEN_END - ORIGIN edge is so cheap that no move ever drops it.
+#define ORIGIN   CITIES           // node (0, 0) of the distances
+#define OPEN_END (CITIES + 1)
+#define NODES    (CITIES + 2)
 
-float getDistance(char a, char b, int coordinates[CITIES][2]){
-   int ia = getIndex(a);
-   int ib = getIndex(b);
-   return sqrt(pow(coordinates[ia][0] - coordinates[ib][0], 2) + pow(coordinates[ia][1] - coordinates[ib][1], 2));
-}
+// Distance functor of improve: the instance's distances plus OPEN_END
+struct OpenPathDistance {
+   const Distances &dist;
+   float operator()(int a, int b) const {
+      if (a == OPEN_END || b == OPEN_END)
+         return (a == ORIGIN || b == ORIGIN) ? -100000 : 0;
+      return dist(a, b);
+   }
+};
 
-float getOriDistance(char b, int coordinates[CITIES][2]){
-   int ib = getIndex(b);
-   return sqrt(pow(0 - coordinates[ib][0], 2) + pow(0 - coordinates[ib][1], 2));
-}
+// Distance of an itinerary: from (0, 0) through all cities. The edges are
+// floats of at least 1 (the cities sit on distinct integer coordinates), so
+// their sum in double is exact whatever the order it is added up in, and an
+// update by the edges a mutation changes gives the same bits as a full sum.
+double tripDistance(const char* itinerary, const Distances &dist){
+   int prevCityIndex = getIndex(itinerary[0]);
+   double distance = dist(ORIGIN, prevCityIndex);
 
-void getComplement(const char* ori, char* tar){
-   string compliment = "9876543210ZYXWVUTSRQPONMLKJIHGFEDCBA";
-   for(int i=0; i<CITIES; i++){
-      char c = ori[i];
-      int index = ( c >= 'A' ) ? c - 'A' : c - '0' + 26;
-      tar[i]=compliment[index];
+   // Start with the second city, and calculate its distance from the prev
+   for (int i = 1; i < CITIES; i++) {
+      int currentCityIndex = getIndex(itinerary[i]);
+      distance += dist(prevCityIndex, currentCityIndex);
+      prevCityIndex = currentCityIndex;
    }
+   return distance;
 }
 
-char getNextCity(const char* chromosome, char c){
-   int index = -1;
-   for(int i=0; i<36; i++){
-      if(chromosome[i]==c) {
-         index = i; break;
-      }
-   }
-   if(index == 35) return chromosome[0];
-   return chromosome[index+1];
+// Distance of the edge into position i of an itinerary (from (0, 0) for i = 0)
+double edgeDistance(const char* itinerary, int i, const Distances &dist){
+   if (i == 0) return dist(ORIGIN, getIndex(itinerary[0]));
+   return dist(getIndex(itinerary[i-1]), getIndex(itinerary[i]));
 }
 
-char getValidCity(char p1Next, char p2Next, bool* visited) {
-   if (!visited[getIndex(p1Next)]) {
-      visited[getIndex(p1Next)] = true;
-      return p1Next;
+// Ranks all trips by distance: a stable LSD radix sort of (fitness bits, slot)
+// keys, 11 bits per pass, ping-ponging between the two key buffers. Fitness
+// is never negative, so its float bits sort like the value.
+void rankTrips(Trip trip[], Ranking &ranking){
+   int n = ranking.n;
+   uint64_t *src = &ranking.keys[0], *dst = &ranking.scratch[0];
+   for (int i = 0; i < n; i++) {
+      float fitness = trip[i].fitness;
+      uint32_t bits;
+      memcpy(&bits, &fitness, sizeof(bits));
+      src[i] = (uint64_t)bits << 32 | (uint32_t)i;
    }
-
-   if (!visited[getIndex(p2Next)]) {
-      visited[getIndex(p2Next)] = true;
-      return p2Next;
+   for (int shift = 32; shift < 64; shift += 11) {
+      int count[2048] = {0};
+      for (int i = 0; i < n; i++) count[(src[i] >> shift) & 2047]++;
+      for (int d = 0, sum = 0; d < 2048; d++) { int c = count[d]; count[d] = sum; sum += c; }
+      for (int i = 0; i < n; i++) dst[count[(src[i] >> shift) & 2047]++] = src[i];
+      uint64_t *temp = src; src = dst; dst = temp;
    }
-
-   char randomCity = getRandomCity();
-   while (visited[getIndex(randomCity)]) randomCity = getRandomCity(); 
-   visited[getIndex(randomCity)] = true;
-   return randomCity;
+   for (int r = 0; r < n; r++) ranking.order[r] = (int)(uint32_t)src[r];
 }
 
 void swap(char * arr, int a, int b){
@@ -90,110 +99,196 @@ void swap(char * arr, int a, int b){
 
 
 /*
- * Evaluates each trip (or chromosome) and sort them out
+ * Evaluates each dirty trip (or chromosome) and rank them.
+ * Trips whose fitness is still valid are not evaluated again.
+ * Returns the number of trips evaluated.
  */
-void evaluate( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] ) {
-   // Precompute distances between cities
-   float distanceMatrix[CITIES][CITIES];
-   #pragma omp parallel for collapse(2)
-   for (int i = 0; i < CITIES; i++) {
-      for (int j = 0; j < CITIES; j++) {
-         distanceMatrix[i][j] = sqrt(pow(coordinates[i][0] - coordinates[j][0], 2) + pow(coordinates[i][1] - coordinates[j][1], 2));
-      }
-   }
+int evaluate( Trip trip[], Ranking &ranking, const Distances &dist ) {
+   int n = ranking.n;
 
-   // Iterating through all trips
-   #pragma omp parallel for
-   for(int i_c = 0; i_c < CHROMOSOMES; i_c++){
-      char prevCity = trip[i_c].itinerary[0];
-      double distance = getOriDistance(prevCity, coordinates);
-      int prevCityIndex = getIndex(trip[i_c].itinerary[0]);
-
-      // Start with the second city, and calculate its distance from the prev
-      for (int i = 1; i < CITIES; i++) {
-         int currentCityIndex = getIndex(trip[i_c].itinerary[i]);
-         distance += distanceMatrix[prevCityIndex][currentCityIndex];
-         prevCityIndex = currentCityIndex;
+   // Iterating through the trips changed since their last evaluation
+   int evaluated = 0;
+   #pragma omp parallel
+   {
+      TELEMETRY_THREAD_START();
+      #pragma omp for reduction(+:evaluated) nowait
+      for(int i_c = 0; i_c < n; i_c++){
+         if (!trip[i_c].dirty) continue;
+
+         // Assign the fitness of this trip with the total calculated distance
+         trip[i_c].fitness = tripDistance(trip[i_c].itinerary, dist);
+         trip[i_c].dirty = false;
+         evaluated++;
       }
-      
-      // Assign the fitness of this trip with the total calculated distance
-      trip[i_c].fitness = distance;
-   }  
+      TELEMETRY_THREAD_STOP(PHASE_EVALUATE);
+   }
 
-   // Sort all trips based on distance using a custome comparator
-   std::sort(trip, trip+CHROMOSOMES, CompareTrips);
+   // Rank all trips based on distance; the trips themselves stay in place
+   telemetry.start(PHASE_RANK);
+   rankTrips(trip, ranking);
+   telemetry.stop(PHASE_RANK);
+   return evaluated;
 }
 
 /*
- * Generates new TOP_X offsprings from TOP_X parents.
+ * Generates new nTop offsprings from nTop parents, in place in trip[].
  * Noe that the i-th and (i+1)-th offsprings are created from the i-th and (i+1)-th parents
+ * with operator op, as op(i, i+1) and op(i+1, i).
+ * Random choices of the i-th pair come from stream i of seed, independent of the thread
+ * Returns the number of trips evaluated: every offspring.
  */
-void crossover( Trip parents[TOP_X], Trip offsprings[TOP_X], int coordinates[CITIES][2] ) {
-   
-   // Precompute distances between cities
-   float distanceMatrix[CITIES][CITIES];
-   #pragma omp parallel for collapse(2)
-   for (int i = 0; i < CITIES; i++) {
-      for (int j = 0; j < CITIES; j++) {
-         distanceMatrix[i][j] = sqrt(pow(coordinates[i][0] - coordinates[j][0], 2) + pow(coordinates[i][1] - coordinates[j][1], 2));
+int crossover( Trip trip[], const int parents[], const int children[], const Distances &dist,
+               uint64_t seed, CrossoverOperator op, int nTop ) {
+   #pragma omp parallel
+   {
+      // Scratch tables of the operators, reused for every pair of this thread
+      CrossoverBuffers buffers(CITIES);
+      TELEMETRY_THREAD_START();
+
+      #pragma omp for nowait
+      for(int i=0; i<nTop; i+=2){
+         Random rng(seed, i);
+
+         const Trip &parent1 = trip[parents[i]], &parent2 = trip[parents[i+1]];
+         Trip &offspring1 = trip[children[i]], &offspring2 = trip[children[i+1]];
+
+         int p1[CITIES], p2[CITIES], child1[CITIES], child2[CITIES];
+         for(int j=0; j<CITIES; j++){
+            p1[j] = getIndex(parent1.itinerary[j]);
+            p2[j] = getIndex(parent2.itinerary[j]);
+         }
+
+         crossoverChild(op, p1, p2, child1, dist, rng, buffers);
+         crossoverChild(op, p2, p1, child2, dist, rng, buffers);
+
+         for(int j=0; j<CITIES; j++){
+            offspring1.itinerary[j] = getCityCh(child1[j]);
+            offspring2.itinerary[j] = getCityCh(child2[j]);
+         }
+         offspring1.itinerary[CITIES] = 0;
+         offspring2.itinerary[CITIES] = 0;
+
+         // the children are hot in cache: evaluate them here, so that mutate
+         // can update their fitness incrementally
+         offspring1.fitness = tripDistance(offspring1.itinerary, dist);
+         offspring2.fitness = tripDistance(offspring2.itinerary, dist);
+         offspring1.dirty = offspring2.dirty = false;
       }
+      TELEMETRY_THREAD_STOP(PHASE_CROSSOVER);
    }
+   return nTop;
+}
 
+/*
+ * Mutate a pair of genes in rate % of the offsprings.
+ * Offspring i draws from stream i of seed, independent of the thread.
+ * The fitness of an evaluated offspring is updated from the (up to) four
+ * edges around the swapped cities instead of being recomputed; the update is
+ * exact (see tripDistance), which a DEBUG build checks against a full sum.
+ * Returns the number of trips evaluated in full: none unless DEBUG.
+ */
+int mutate( Trip trip[], const int children[], const Distances &dist, uint64_t seed, int nTop, int rate ) {
+   int evaluated = 0;
    #pragma omp parallel
    {
-      // Generate a different seed for each thread
-      srand(time(NULL) + omp_get_thread_num());
-
-      #pragma omp for
-      for(int i=0; i<TOP_X; i+=2){
-         // Hash set for visited cities
-         bool visited[36] = {false};
-         
-         offsprings[i].itinerary[0] = parents[i].itinerary[0];
-         visited[getIndex(offsprings[i].itinerary[0])] = true;
-         
-         // Greedy cross over
-         for(int j=1; j<36; j++){
-            char startingCity = offsprings[i].itinerary[j-1];
-
-            char p1Next = getNextCity(parents[i].itinerary, startingCity);
-            char p2Next = getNextCity(parents[i+1].itinerary, startingCity);
-
-            float d1 = distanceMatrix[getIndex(startingCity)][getIndex(p1Next)];
-            float d2 = distanceMatrix[getIndex(startingCity)][getIndex(p2Next)];
-
-            if (d1 <= d2) {
-               offsprings[i].itinerary[j] = getValidCity(p1Next, p2Next, visited);
-            } else {
-               offsprings[i].itinerary[j] = getValidCity(p2Next, p1Next, visited);
+      TELEMETRY_THREAD_START();
+      #pragma omp for reduction(+:evaluated) nowait
+      for (int i = 0; i < nTop; i++) {
+         Random rng(seed, i);
+         Trip &offspring = trip[children[i]];
+         int prob = rng.nextInt(100);
+         if (prob < rate){
+            int a = rng.nextInt(CITIES);  
+            int b = rng.nextInt(CITIES - 1);
+            if (b >= a) b++;                  // any city but a, without retrying
+            if (a > b) { int temp = a; a = b; b = temp; }
+
+            // edges into positions a, a+1, b and b+1 (b+1 == CITIES is no edge)
+            int edges[4] = { a, a + 1, b, b + 1 };
+            int nEdges = (b == a + 1) ? 3 : 4;
+            if (b == a + 1) edges[2] = b + 1;
+            if (edges[nEdges - 1] == CITIES) nEdges--;
+
+            double delta = 0;
+            if (!offspring.dirty)
+               for (int e = 0; e < nEdges; e++) delta -= edgeDistance(offspring.itinerary, edges[e], dist);
+            swap(offspring.itinerary, a, b);  
+            if (!offspring.dirty) {
+               for (int e = 0; e < nEdges; e++) delta += edgeDistance(offspring.itinerary, edges[e], dist);
+               offspring.fitness += delta;
+               if (DEBUG) {
+                  evaluated++;
+                  if (offspring.fitness != tripDistance(offspring.itinerary, dist))
+                     cout << "mutate: fitness " << offspring.fitness << " of " << offspring.itinerary
+                          << " is not its distance " << tripDistance(offspring.itinerary, dist) << endl;
+               }
             }
          }
-
-         // Generate complement 
-         getComplement(offsprings[i].itinerary, offsprings[i+1].itinerary);      
       }
+      TELEMETRY_THREAD_STOP(PHASE_MUTATE);
    }
+   return evaluated;
 }
 
 /*
- * Mutate a pair of genes in each offspring.
+ * Memetic stage: improves each offspring to a 2-opt / Or-opt local optimum.
  */
-void mutate( Trip offsprings[TOP_X] ) {
+void improve( Trip trip[], const int children[], const Distances &distances, int nTop ) {
+   // Distances between the cities, ORIGIN and OPEN_END
+   OpenPathDistance dist = { distances };
+   NeighbourLists neighbours(NODES, LS_NEIGHBOURS, dist);
+
    #pragma omp parallel
-   {  
-      // Generate a different seed for each thread
-      srand(time(NULL) + omp_get_thread_num());
-
-      #pragma omp for 
-      for (int i = 0; i < TOP_X; i++) {
-         int prob = rand() % 100;
-         if (prob < MUTATE_RATE){
-            int a = rand() % CITIES;  
-            int b = rand() % CITIES;
-            while (b == a) b = rand() % CITIES; 
-            swap(offsprings[i].itinerary, a, b);  
+   {
+      LocalSearchBuffers buffers(NODES);
+      TELEMETRY_THREAD_START();
+
+      #pragma omp for schedule(dynamic, 256) nowait
+      for (int i = 0; i < nTop; i++) {
+         Trip &offspring = trip[children[i]];
+         int tour[NODES];
+         tour[0] = ORIGIN;
+         for (int j = 0; j < CITIES; j++) tour[j + 1] = getIndex(offspring.itinerary[j]);
+         tour[CITIES + 1] = OPEN_END;
+
+         improveTour(tour, dist, neighbours, buffers);
+
+         // read the path out from ORIGIN, away from OPEN_END
+         int at = 0;
+         while (tour[at] != ORIGIN) at++;
+         int step = (tour[(at + 1) % NODES] == OPEN_END) ? NODES - 1 : 1;
+         double distance = 0;
+         for (int j = 0, prev = ORIGIN; j < CITIES; j++) {
+            at = (at + step) % NODES;
+            offspring.itinerary[j] = getCityCh(tour[at]);
+            distance += distances(prev, tour[at]);
+            prev = tour[at];
          }
+         offspring.fitness = distance;
+         offspring.dirty = false;
       }
+      TELEMETRY_THREAD_STOP(PHASE_IMPROVE);
    }
 }
 
+/*
+ * Diversity of a ranked population: the mean share of the best trip's edges
+ * that DIVERSITY_SAMPLE trips spread evenly over the ranks do not have.
+ */
+float diversity( const Trip trip[], const Ranking &ranking ) {
+   int n = ranking.n;
+
+   // next[c] = the city after c in the best trip (0 for the last one)
+   const char *best = trip[ranking.order[0]].itinerary;
+   char next[128] = {0};
+   for (int j = 0; j + 1 < CITIES; j++) next[(int)best[j]] = best[j + 1];
+
+   int sample = (n - 1 < DIVERSITY_SAMPLE) ? n - 1 : DIVERSITY_SAMPLE;
+   long missing = 0;
+   for (int s = 1; s <= sample; s++) {
+      const char *other = trip[ranking.order[(long)s * (n - 1) / sample]].itinerary;
+      for (int j = 0; j + 1 < CITIES; j++)
+         if (next[(int)other[j]] != other[j + 1] && next[(int)other[j + 1]] != other[j]) missing++;
+   }
+   return sample > 0 ? (float)missing / ((float)sample * (CITIES - 1)) : 0;
+}
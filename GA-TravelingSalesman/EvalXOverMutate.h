@@ -0,0 +1,57 @@
+#ifndef _EVALXOVERMUTATE_H_
+#define _EVALXOVERMUTATE_H_
+
+#include <stdint.h>
+#include <vector>
+#include "Trip.h"
+#include "Crossover.h"
+#include "Distances.h"
+
+using namespace std;
+
+// GA operators, see EvalXOverMutate.cpp. They look distances up in the
+// instance's Distances of the CITIES cities with origin (0, 0) as node CITIES.
+//
+// Trips never move: a population is an arena trip[0..n) plus its Ranking.
+// Parents are the slots of the best ranks and offsprings are written straight
+// into the slots of the worst ranks, so a generation copies no Trip at all.
+// They work on the whole population by default; an island passes the size of
+// its own sub-population instead.
+
+// Ranks of a population: order[r] = slot of the r-th shortest trip. keys and
+// scratch are the two buffers the radix sort ping-pongs between.
+class Ranking {
+public:
+  Ranking( int n = CHROMOSOMES ) : n( n ), order( n ), keys( n ), scratch( n ) { }
+
+  const int *parents( ) const { return &order[0]; }                 // best slots first
+  const int *children( int nTop ) const { return &order[n - nTop]; } // worst nTop slots
+
+  int n;
+  vector<int> order;
+  vector<uint64_t> keys, scratch;
+};
+
+// evaluates dirty trips, ranks trip[0..ranking.n) by fitness, returns # trips evaluated
+int evaluate( Trip trip[], Ranking &ranking, const Distances &dist );
+
+// writes nTop offsprings into slots children[] from the parents in slots parents[] (nTop is even),
+// evaluated; returns # trips evaluated
+int crossover( Trip trip[], const int parents[], const int children[], const Distances &dist,
+               uint64_t seed, CrossoverOperator op, int nTop = TOP_X );
+
+// swaps a pair of genes in rate % of the nTop offsprings in slots children[],
+// updating the fitness of those evaluated by the edges swapped; returns #
+// trips evaluated in full (only to check the update in DEBUG builds)
+int mutate( Trip trip[], const int children[], const Distances &dist, uint64_t seed, int nTop = TOP_X,
+             int rate = MUTATE_RATE );
+
+// memetic stage: 2-opt / Or-opt local search on the nTop offsprings in slots children[]
+void improve( Trip trip[], const int children[], const Distances &dist, int nTop = TOP_X );
+
+// share of the best trip's edges missing from a sample of the others, from
+// 1 for unrelated trips down to 0 once the population has converged
+#define DIVERSITY_SAMPLE 256   // trips compared with the best one
+float diversity( const Trip trip[], const Ranking &ranking );
+
+#endif
@@ -0,0 +1,106 @@
+#include <iostream>  // cout
+#include <omp.h>     // OpenMP
+#include <algorithm> // swap
+#include "Island.h"
+#include "Random.h"
+#include "EvalXOverMutate.h"
+
+using namespace std;
+
+// Producer side: publish one migrant unless the consumer is a full ring behind
+bool MigrationRing::push( const Trip &trip ) {
+  unsigned t = tail.load( memory_order_relaxed );
+  if ( t - head.load( memory_order_acquire ) == RING_CAPACITY )
+    return false;
+  slots[t & ( RING_CAPACITY - 1 )] = trip;
+  tail.store( t + 1, memory_order_release );
+  return true;
+}
+
+// Consumer side: take the oldest migrant, if any
+bool MigrationRing::pop( Trip &trip ) {
+  unsigned h = head.load( memory_order_relaxed );
+  if ( tail.load( memory_order_acquire ) == h )
+    return false;
+  trip = slots[h & ( RING_CAPACITY - 1 )];
+  head.store( h + 1, memory_order_release );
+  return true;
+}
+
+/*
+ * Island model. There is no barrier between islands: each one runs its own
+ * evaluate / crossover / mutate loop on its own trips and ranking, and only
+ * touches the two rings next to it.
+ *
+ * Migrants arrive whenever their sender gets there, so unlike the panmictic
+ * mode a run is not replayed bit-for-bit from its seed.
+ */
+void evolveIslands( Trip trip[], int population, const Distances &dist, int nIslands, int nThreads,
+                    uint64_t seed, CrossoverOperator op, bool localSearch, Trip &shortest,
+                    ExternalMigration *external ) {
+  int groupSize = ( nThreads > nIslands ) ? nThreads / nIslands : 1;
+  MigrationRing *rings = new MigrationRing[nIslands];  // rings[i]: island i-1 -> island i
+
+  // thread groups: one outer thread per island, groupSize threads inside its operators
+  omp_set_max_active_levels( groupSize > 1 ? 2 : 1 );
+
+  #pragma omp parallel num_threads( nIslands )
+  {
+    int island = omp_get_thread_num( );
+    // island i holds trip[start(i) .. start(i + 1)): the remainder is shared too
+    int first = ( long )island * population / nIslands;
+    int n = ( long )( island + 1 ) * population / nIslands - first;   // trips of this island
+    int nTop = ( n / 2 ) & ~1;      // parents / offsprings of this island, even for pairs
+    Trip *trips = trip + first;
+    Ranking ranking( n );
+    const int *parents = ranking.parents( );
+    const int *children = ranking.children( nTop );
+    Trip elites[MIGRANTS], migrants[MIGRANTS];
+    uint64_t islandSeed = Random::derive( seed, ( uint64_t )1 << 40 | island );
+    omp_set_num_threads( groupSize );
+
+    for ( int generation = 0; generation < MAX_GENERATION; generation++ ) {
+      evaluate( trips, ranking, dist );
+
+      crossover( trips, parents, children, dist, Random::derive( islandSeed, 2 * generation ), op, nTop );
+      mutate( trips, children, dist, Random::derive( islandSeed, 2 * generation + 1 ), nTop );
+      if ( localSearch )
+        improve( trips, children, dist, nTop );
+
+      // send the elites (the parents' slots are untouched) and let immigrants
+      // replace the last offsprings
+      if ( generation % MIGRATION_INTERVAL != MIGRATION_INTERVAL - 1 )
+        continue;
+      for ( int i = 0; i < MIGRANTS; i++ )
+        elites[i] = trips[parents[i]];
+      if ( nIslands > 1 ) {
+        for ( int i = 0; i < MIGRANTS; i++ )
+          rings[( island + 1 ) % nIslands].push( elites[i] );
+        for ( int i = 0; i < MIGRANTS && rings[island].pop( trips[ranking.order[n - 1 - i]] ); i++ )
+          ;
+      }
+      if ( external != NULL && island == 0 ) {
+        external->send( elites, MIGRANTS, generation );
+        int received = external->receive( migrants, MIGRANTS );
+        for ( int i = 0; i < received; i++ )
+          trips[ranking.order[n - 2 * MIGRANTS + i]] = migrants[i];
+      }
+    }
+    evaluate( trips, ranking, dist );
+
+    // the island's shortest path goes first, for the caller
+    if ( ranking.order[0] != 0 )
+      swap( trips[0], trips[ranking.order[0]] );
+  }
+
+  // the shortest path of all islands
+  int best = 0;
+  for ( int island = 1; island < nIslands; island++ ) {
+    int first = ( long )island * population / nIslands;
+    if ( trip[first].fitness < trip[best].fitness )
+      best = first;
+  }
+  shortest = trip[best];
+
+  delete[] rings;
+}
@@ -0,0 +1,48 @@
+#ifndef _ISLAND_H_
+#define _ISLAND_H_
+
+#include <atomic>
+#include <stddef.h>  // NULL
+#include "Trip.h"
+#include "Crossover.h"
+#include "Distances.h"
+
+#define MIGRATION_INTERVAL 10  // generations between two migrations
+#define MIGRANTS           4   // elites an island sends per migration
+#define RING_CAPACITY      16  // migrants a ring can buffer (power of 2)
+
+// Single-producer / single-consumer ring buffer of migrants from one island
+// to the next one. Neither side ever waits: a full ring drops the migrant and
+// an empty ring simply delivers nothing.
+class MigrationRing {
+public:
+  MigrationRing( ) : head( 0 ), tail( 0 ) { }
+  bool push( const Trip &trip );   // producer side; false if full
+  bool pop( Trip &trip );          // consumer side; false if empty
+
+private:
+  Trip slots[RING_CAPACITY];
+  alignas( 64 ) std::atomic<unsigned> head;   // next slot to read
+  alignas( 64 ) std::atomic<unsigned> tail;   // next slot to write
+};
+
+// Migrants leaving and entering this process (see Distributed.cpp). Only the
+// thread of island 0 calls it, at its migration points.
+class ExternalMigration {
+public:
+  virtual ~ExternalMigration( ) { }
+  virtual void send( const Trip elites[], int count, int generation ) = 0;
+  virtual int receive( Trip migrants[], int max ) = 0;   // returns # migrants
+};
+
+// Evolves trip[0..population) as nIslands sub-populations of population / nIslands
+// trips (the first population % nIslands islands take one more), one per
+// thread group of nThreads >= nIslands threads, for MAX_GENERATION generations. Every
+// MIGRATION_INTERVAL generations each island sends its MIGRANTS best trips to
+// the next island on a ring, and island 0 also exchanges migrants through
+// external if there is one. The shortest trip found is returned in shortest.
+void evolveIslands( Trip trip[], int population, const Distances &dist, int nIslands, int nThreads,
+                    uint64_t seed, CrossoverOperator op, bool localSearch, Trip &shortest,
+                    ExternalMigration *external = NULL );
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef _LOCALSEARCH_H_
+#define _LOCALSEARCH_H_
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// 2-opt and Or-opt improvement of closed tours of n nodes 0..n-1, given as
+// node indices, driven by neighbour lists and don't-look bits.
+//
+// Only edges to one of the k nearest nodes of a city are tried, and only the
+// cities around a change are looked at again, so a locally optimal tour is
+// reached in close to O(n * k) work after the first pass.
+
+#define LS_NEIGHBOURS  8    // k nearest nodes per node
+#define LS_EPSILON     1e-4 // minimum gain of an applied move
+
+// The k nearest nodes of every node, nearest first
+class NeighbourLists {
+public:
+  template <class Distance>
+  NeighbourLists( int n, int k, const Distance &dist ) : n( n ), k( k < n - 1 ? k : n - 1 ), near( n * this->k ) {
+    vector< pair<float, int> > order( n );
+    for ( int a = 0; a < n; a++ ) {
+      int m = 0;
+      for ( int b = 0; b < n; b++ )
+        if ( b != a )
+          order[m++] = make_pair( ( float )dist( a, b ), b );
+      partial_sort( order.begin( ), order.begin( ) + this->k, order.begin( ) + m );
+      for ( int i = 0; i < this->k; i++ )
+        near[a * this->k + i] = order[i].second;
+    }
+  }
+
+  const int *of( int a ) const { return &near[a * k]; }
+
+  int n, k;
+  vector<int> near;  // near[a * k + i] = the (i+1)-th nearest node of a
+};
+
+// Scratch tables of one thread, allocated once for n nodes
+class LocalSearchBuffers {
+public:
+  LocalSearchBuffers( int n ) : n( n ), pos( n ), queue( n ), queued( n ) { }
+
+  // Fits the tables to n nodes; they only reallocate when n exceeds any earlier n
+  void resize( int n ) {
+    this->n = n;
+    pos.resize( n ); queue.resize( n ); queued.resize( n );
+  }
+
+  int n;
+  vector<int> pos;     // pos[a] = index of node a in the tour
+  vector<int> queue;   // FIFO of nodes whose don't-look bit is off
+  vector<char> queued; // don't-look bit is off
+};
+
+// Local search on one tour; the tour array is modified in place
+template <class Distance>
+class LocalSearch {
+public:
+  LocalSearch( int tour[], const Distance &dist, const NeighbourLists &nl, LocalSearchBuffers &buf )
+    : t( tour ), dist( dist ), nl( nl ), n( buf.n ), pos( &buf.pos[0] ),
+      queue( &buf.queue[0] ), queued( &buf.queued[0] ), head( 0 ), size( 0 ) { }
+
+  /*
+   * Applies improving 2-opt and Or-opt moves until none is left.
+   * Returns the total gain (decrease in tour length).
+   */
+  double run( bool useOrOpt = true ) {
+    double gain = 0;
+    for ( int i = 0; i < n; i++ ) {
+      pos[t[i]] = i;
+      queue[i] = t[i];
+      queued[t[i]] = 1;
+    }
+    head = 0;
+    size = n;
+
+    while ( size > 0 ) {
+      int a = queue[head];
+      head = ( head + 1 == n ) ? 0 : head + 1;
+      size--;
+      queued[a] = 0;
+
+      float g = twoOptFrom( a );
+      if ( g <= 0 && useOrOpt )
+        g = orOptFrom( a );
+      if ( g > 0 ) {
+        gain += g;
+        push( a );
+      }
+    }
+    return gain;
+  }
+
+private:
+  int *t;
+  const Distance &dist;
+  const NeighbourLists &nl;
+  int n;
+  int *pos, *queue;
+  char *queued;
+  int head, size;
+
+  int next( int a ) const { return t[pos[a] + 1 == n ? 0 : pos[a] + 1]; }
+  int prev( int a ) const { return t[pos[a] == 0 ? n - 1 : pos[a] - 1]; }
+
+  // Turns the don't-look bit of a off
+  void push( int a ) {
+    if ( queued[a] )
+      return;
+    queued[a] = 1;
+    int tail = head + size;
+    queue[tail >= n ? tail - n : tail] = a;
+    size++;
+  }
+
+  // Reverses the len nodes starting at index i, wrapping around the array
+  void reverse( int i, int len ) {
+    int j = i + len - 1;
+    if ( j >= n ) j -= n;
+    for ( int s = 0; s < len / 2; s++ ) {
+      int a = t[i], b = t[j];
+      t[i] = b; pos[b] = i;
+      t[j] = a; pos[a] = j;
+      i = ( i + 1 == n ) ? 0 : i + 1;
+      j = ( j == 0 ) ? n - 1 : j - 1;
+    }
+  }
+
+  // Reverses the path from node b forward to node c, or its complement
+  // when that is shorter (both give the same tour)
+  void reversePath( int b, int c ) {
+    int len = pos[c] - pos[b];
+    if ( len < 0 ) len += n;
+    len++;
+    if ( 2 * len <= n )
+      reverse( pos[b], len );
+    else if ( len < n )
+      reverse( pos[c] + 1 == n ? 0 : pos[c] + 1, n - len );
+  }
+
+  /*
+   * 2-opt from a: replace (a, succ a) and (c, succ c) by (a, c) and
+   * (succ a, succ c), or the same with predecessors, for c near a.
+   */
+  float twoOptFrom( int a ) {
+    const int *near = nl.of( a );
+    for ( int dir = 0; dir < 2; dir++ ) {
+      int b = dir ? prev( a ) : next( a );
+      float dab = dist( a, b );
+      for ( int i = 0; i < nl.k; i++ ) {
+        int c = near[i];
+        float dac = dist( a, c );
+        if ( dac >= dab )
+          break;                       // no gain possible with farther c
+        int d = dir ? prev( c ) : next( c );
+        if ( c == b || d == a )
+          continue;
+        float g = dab + dist( c, d ) - dac - dist( b, d );
+        if ( g > LS_EPSILON ) {
+          if ( dir == 0 )
+            reversePath( b, c );       // a -> c ... b -> d
+          else
+            reversePath( c, b );       // d <- b ... c <- a, reversed
+          push( b ); push( c ); push( d );
+          return g;
+        }
+      }
+    }
+    return 0;
+  }
+
+  /*
+   * Or-opt from a: move the segment of 1 to 3 nodes starting at a next to a
+   * near node c, in either orientation.
+   */
+  float orOptFrom( int a ) {
+    for ( int len = 1; len <= 3 && len + 3 <= n; len++ ) {
+      int p = prev( a ), e = a;
+      for ( int s = 1; s < len; s++ )
+        e = next( e );
+      int f = next( e );
+      float removed = dist( p, a ) + dist( e, f ) - dist( p, f );
+      if ( removed <= LS_EPSILON )
+        continue;
+
+      // insert between x and y = succ x so that a or e ends up next to c
+      for ( int end = 0; end < 2; end++ ) {
+        int u = end ? e : a;
+        const int *near = nl.of( u );
+        for ( int i = 0; i < nl.k; i++ ) {
+          int c = near[i];
+          float duc = dist( u, c );
+          if ( duc >= removed )
+            break;
+          if ( inSegment( c, a, len ) )
+            continue;
+          for ( int side = 0; side < 2; side++ ) {
+            int x = side ? prev( c ) : c;
+            int y = side ? c : next( c );
+            if ( inSegment( x, a, len ) || inSegment( y, a, len ) )
+              continue;
+            // side 0: c - u ... - y; side 1: x - ... u - c
+            bool reversed = ( side == 0 ) == ( end == 1 );
+            float added = reversed ? dist( x, e ) + dist( a, y ) : dist( x, a ) + dist( e, y );
+            float g = removed - ( added - dist( x, y ) );
+            if ( g > LS_EPSILON ) {
+              moveSegment( a, len, x, reversed );
+              push( p ); push( f ); push( x ); push( y ); push( e );
+              return g;
+            }
+          }
+        }
+      }
+    }
+    return 0;
+  }
+
+  bool inSegment( int c, int a, int len ) const {
+    int d = pos[c] - pos[a];
+    if ( d < 0 ) d += n;
+    return d < len;
+  }
+
+  /*
+   * Moves the len nodes starting at a between x and y = succ x, reversed or
+   * not, by rotating the shorter stretch of tour in between with reversals.
+   */
+  void moveSegment( int a, int len, int x, bool reversed ) {
+    int i = pos[a];
+    int afterSeg = ( i + len ) % n;
+    int y = next( x );
+    int forward = pos[x] - afterSeg;   // M = [afterSeg .. x] follows the segment
+    if ( forward < 0 ) forward += n;
+    forward++;
+    int backward = i - pos[y];         // M = [y .. before segment] precedes it
+    if ( backward < 0 ) backward += n;
+
+    if ( forward <= backward ) {
+      // [S][M] -> [M][S] or [M][S^R]
+      reverse( i, len + forward );     // [M^R][S^R]
+      reverse( i, forward );           // [M][S^R]
+      if ( !reversed )
+        reverse( ( i + forward ) % n, len );
+    } else {
+      // [M][S] -> [S][M] or [S^R][M]
+      int j = pos[y];
+      reverse( j, backward + len );    // [S^R][M^R]
+      reverse( ( j + len ) % n, backward );
+      if ( !reversed )
+        reverse( j, len );
+    }
+  }
+};
+
+/*
+ * Runs 2-opt + Or-opt on tour until it is locally optimal.
+ * Returns the decrease in tour length.
+ */
+template <class Distance>
+double improveTour( int tour[], const Distance &dist, const NeighbourLists &nl, LocalSearchBuffers &buf ) {
+  LocalSearch<Distance> search( tour, dist, nl, buf );
+  return search.run( );
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <stdint.h>
+
+// Per-stream random number generator (xoshiro128**) seeded through splitmix64.
+//
+// Every random decision in the GA is drawn from a stream identified by
+// ( seed, stream ), e.g. ( generation seed, chromosome index ). The numbers a
+// chromosome sees therefore never depend on which OpenMP thread processes it,
+// and a run can be replayed bit-for-bit with any # threads from its master seed.
+class Random {
+public:
+  Random( uint64_t seed, uint64_t stream ) {
+    uint64_t x = derive( seed, stream );
+    uint64_t a = splitmix64( x );
+    uint64_t b = splitmix64( x );
+    s[0] = ( uint32_t )a; s[1] = ( uint32_t )( a >> 32 );
+    s[2] = ( uint32_t )b; s[3] = ( uint32_t )( b >> 32 );
+    if ( ( s[0] | s[1] | s[2] | s[3] ) == 0 )
+      s[0] = 1;                            // xoshiro must not start all-zero
+  }
+
+  // Next 32 random bits
+  uint32_t next( ) {
+    uint32_t result = rotl( s[1] * 5, 7 ) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl( s[3], 11 );
+    return result;
+  }
+
+  // Uniform integer in [0, bound) (multiply-shift, no division)
+  int nextInt( int bound ) {
+    return ( int )( ( ( uint64_t )next( ) * ( uint32_t )bound ) >> 32 );
+  }
+
+  // Mixes a seed and a stream id into an independent 64-bit seed
+  static uint64_t derive( uint64_t seed, uint64_t stream ) {
+    return mix64( seed ^ mix64( stream + 0x9E3779B97F4A7C15ULL ) );
+  }
+
+private:
+  uint32_t s[4];
+
+  static uint32_t rotl( uint32_t x, int k ) {
+    return ( x << k ) | ( x >> ( 32 - k ) );
+  }
+
+  static uint64_t mix64( uint64_t z ) {
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+  }
+
+  static uint64_t splitmix64( uint64_t &x ) {
+    x += 0x9E3779B97F4A7C15ULL;
+    return mix64( x );
+  }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _RUNCONTROL_H_
+#define _RUNCONTROL_H_
+
+#include <stddef.h>  // NULL
+#include "Trip.h"
+
+// Run control of the panmictic GA: when to stop before MAX_GENERATION, and
+// how much to mutate while the shortest trip does not improve.
+
+#define MUTATE_STALL   5     // stalled generations before the rate goes up
+#define MUTATE_STEP    10    // % added per further stalled generation
+#define MUTATE_MAX     100   // highest adaptive rate
+
+// Stopping policies, checked once per generation after evaluate. A policy
+// is off while its limit is 0.
+class StoppingPolicy {
+public:
+  StoppingPolicy( ) : stallLimit( 0 ), target( 0 ), budget( 0 ), minDiversity( 0 ),
+                      stalled( 0 ), shortest( -1 ), previous( 0 ) { }
+
+  int stallLimit;       // generations without a shorter trip
+  float target;         // tour length that is good enough
+  long budget;          // usec of wall time; stops before a generation would exceed it
+  float minDiversity;   // diversity (see EvalXOverMutate.h) of a collapsed population
+
+  /*
+   * Returns why the run stops after this generation, or NULL to go on
+   *
+   * @param best:      distance of the shortest trip of this generation
+   * @param diversity: diversity of this generation
+   * @param elapsed:   usec since the run started
+   */
+  const char *check( float best, float diversity, long elapsed ) {
+    stalled = ( shortest < 0 || best < shortest ) ? 0 : stalled + 1;
+    if ( shortest < 0 || best < shortest )
+      shortest = best;
+    long last = elapsed - previous;   // the next generation should take as long
+    previous = elapsed;
+
+    if ( target > 0 && shortest <= target )
+      return "target";
+    if ( stallLimit > 0 && stalled >= stallLimit )
+      return "stall";
+    if ( minDiversity > 0 && diversity < minDiversity )
+      return "diversity";
+    if ( budget > 0 && elapsed + last > budget )
+      return "time budget";
+    return NULL;
+  }
+
+  // diversity is only needed when a policy looks at it
+  bool needsDiversity( ) const { return minDiversity > 0; }
+
+  int stalled;          // generations since the shortest trip last improved
+
+private:
+  float shortest;
+  long previous;
+};
+
+// Adaptive mutation rate: MUTATE_STEP % more for each generation past
+// MUTATE_STALL without a shorter trip, back to the base rate on improvement.
+// A fixed controller always returns the base rate.
+class MutationControl {
+public:
+  MutationControl( int base = MUTATE_RATE, bool adaptive = false )
+    : base( base ), adaptive( adaptive ), rate( base ) { }
+
+  // Rate of the next generation, given the generations stalled so far
+  int update( int stalled ) {
+    rate = base;
+    if ( adaptive && stalled > MUTATE_STALL )
+      rate = base + ( stalled - MUTATE_STALL ) * MUTATE_STEP;
+    if ( rate > MUTATE_MAX )
+      rate = MUTATE_MAX;
+    return rate;
+  }
+
+  int base;
+  bool adaptive;
+  int rate;
+};
+
+#endif
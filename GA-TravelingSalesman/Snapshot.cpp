@@ -0,0 +1,154 @@
+#include <iostream>     // cerr
+#include <string>       // string
+#include <stdio.h>      // fopen, fwrite, rename
+#include <string.h>     // memset, memcpy, strcmp
+#include <unistd.h>     // close
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // fstat
+#include <omp.h>        // OpenMP
+#include "Snapshot.h"
+
+using namespace std;
+
+#define SNAPSHOT_MAGIC   "TSPSNAP"
+#define SNAPSHOT_VERSION 1
+#define WRITE_BATCH      4096   // packed trips per fwrite
+
+static_assert( CITIES % 4 == 0, "trips are packed four cities (three bytes) at a time" );
+
+// The fixed-size header of a snapshot; the packed trips follow it
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t cities;
+  uint32_t chromosomes;
+  uint32_t generation;     // next generation to run
+  uint64_t seed;           // master seed of the run
+  int32_t coordinates[CITIES][2];
+};
+
+/*
+ * Packs the itinerary as 6-bit city indices, followed by the fitness.
+ * Four cities fill three bytes exactly, so they go a group at a time.
+ */
+void packTrip( const Trip &trip, unsigned char out[PACKED_TRIP] ) {
+  memset( out, 0, PACKED_TRIP );
+  for ( int i = 0; i < CITIES; i += 4 ) {
+    uint32_t group = 0;
+    for ( int k = 0; k < 4; k++ ) {
+      char c = trip.itinerary[i + k];
+      group |= ( uint32_t )( ( c >= 'A' ) ? c - 'A' : c - '0' + 26 ) << ( k * CITY_BITS );
+    }
+    unsigned char *p = out + i / 4 * 3;
+    p[0] = group;
+    p[1] = group >> 8;
+    p[2] = group >> 16;
+  }
+  float fitness = trip.dirty ? -1.0f : trip.fitness;
+  memcpy( out + PACKED_TRIP - 4, &fitness, 4 );
+}
+
+/*
+ * Inverse of packTrip
+ */
+void unpackTrip( const unsigned char in[PACKED_TRIP], Trip &trip ) {
+  static const char names[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  for ( int i = 0; i < CITIES; i += 4 ) {
+    const unsigned char *p = in + i / 4 * 3;
+    uint32_t group = p[0] | p[1] << 8 | p[2] << 16;
+    for ( int k = 0; k < 4; k++ )
+      trip.itinerary[i + k] = names[( group >> ( k * CITY_BITS ) ) & 63];
+  }
+  trip.itinerary[CITIES] = 0;
+  // the fitness travels as a float: kept for display, but the trip is
+  // evaluated again before any incremental update relies on it
+  float fitness;
+  memcpy( &fitness, in + PACKED_TRIP - 4, 4 );
+  trip.fitness = ( fitness < 0 ) ? 0.0 : fitness;
+  trip.dirty = true;
+}
+
+/*
+ * Writes the snapshot to path + ".tmp", then renames it over path
+ */
+bool saveSnapshot( const char path[], const Trip trip[], int n, int coordinates[CITIES][2],
+                   uint64_t seed, int generation ) {
+  SnapshotHeader header;
+  memset( &header, 0, sizeof( header ) );
+  strcpy( header.magic, SNAPSHOT_MAGIC );
+  header.version = SNAPSHOT_VERSION;
+  header.cities = CITIES;
+  header.chromosomes = n;
+  header.generation = generation;
+  header.seed = seed;
+  for ( int i = 0; i < CITIES; i++ ) {
+    header.coordinates[i][0] = coordinates[i][0];
+    header.coordinates[i][1] = coordinates[i][1];
+  }
+
+  string temp = string( path ) + ".tmp";
+  FILE *file = fopen( temp.c_str( ), "wb" );
+  if ( file == NULL ) {
+    cerr << "snapshot: cannot write " << temp << endl;
+    return false;
+  }
+  bool ok = fwrite( &header, sizeof( header ), 1, file ) == 1;
+  unsigned char *batch = new unsigned char[WRITE_BATCH * PACKED_TRIP];
+  for ( int first = 0; ok && first < n; first += WRITE_BATCH ) {
+    int count = ( n - first < WRITE_BATCH ) ? n - first : WRITE_BATCH;
+    for ( int i = 0; i < count; i++ )
+      packTrip( trip[first + i], batch + i * PACKED_TRIP );
+    ok = fwrite( batch, PACKED_TRIP, count, file ) == ( size_t )count;
+  }
+  delete[] batch;
+  ok = ( fclose( file ) == 0 ) && ok;
+  if ( ok )
+    ok = rename( temp.c_str( ), path ) == 0;
+  if ( !ok ) {
+    cerr << "snapshot: cannot write " << path << endl;
+    remove( temp.c_str( ) );
+  }
+  return ok;
+}
+
+/*
+ * Maps the snapshot read-only and unpacks the trips in parallel
+ */
+bool loadSnapshot( const char path[], Trip trip[], int n, int coordinates[CITIES][2],
+                   uint64_t &seed, int &generation ) {
+  int fd = open( path, O_RDONLY );
+  if ( fd < 0 )
+    return false;
+  struct stat st;
+  size_t size = ( fstat( fd, &st ) == 0 ) ? st.st_size : 0;
+  void *map = ( size >= sizeof( SnapshotHeader ) ) ? mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED;
+  close( fd );
+  if ( map == MAP_FAILED ) {
+    cerr << "snapshot: cannot map " << path << endl;
+    return false;
+  }
+
+  const SnapshotHeader *header = ( const SnapshotHeader * )map;
+  const unsigned char *packed = ( const unsigned char * )map + sizeof( SnapshotHeader );
+  bool ok = strcmp( header->magic, SNAPSHOT_MAGIC ) == 0 && header->version == SNAPSHOT_VERSION
+    && header->cities == CITIES && header->chromosomes == ( uint32_t )n
+    && size == sizeof( SnapshotHeader ) + ( size_t )n * PACKED_TRIP;
+  if ( ok ) {
+    madvise( map, size, MADV_SEQUENTIAL );
+    #pragma omp parallel for
+    for ( int i = 0; i < n; i++ )
+      unpackTrip( packed + ( size_t )i * PACKED_TRIP, trip[i] );
+    for ( int i = 0; i < CITIES; i++ ) {
+      coordinates[i][0] = header->coordinates[i][0];
+      coordinates[i][1] = header->coordinates[i][1];
+    }
+    seed = header->seed;
+    generation = header->generation;
+  }
+  else
+    cerr << "snapshot: " << path << " is not a snapshot of " << n << " trips of "
+         << CITIES << " cities" << endl;
+  munmap( map, size );
+  return ok;
+}
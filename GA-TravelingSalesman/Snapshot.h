@@ -0,0 +1,36 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdint.h>
+#include "Trip.h"
+
+// Binary population snapshots: a header followed by one packed trip per
+// chromosome. They replace the text chromosome.txt / cities.txt at start-up
+// and are the checkpoints a run is resumed from.
+
+#define POPULATION_FILE "chromosome.bin"  // initial population written by initialize
+#define CHECKPOINT_FILE "checkpoint.bin"  // latest checkpoint of Tsp
+
+// A packed trip, on the wire and on disk: 6 bits per city index, then the
+// fitness as a float (host order). A negative fitness stands for a dirty
+// trip; an unpacked trip is always dirty, as its float fitness is not the
+// exact distance an incremental update needs.
+#define CITY_BITS   6
+#define PACKED_TRIP ( ( CITIES * CITY_BITS + 7 ) / 8 + 4 )
+
+void packTrip( const Trip &trip, unsigned char out[PACKED_TRIP] );
+void unpackTrip( const unsigned char in[PACKED_TRIP], Trip &trip );
+
+// Writes trip[0..n), the cities, the master seed and the next generation to
+// path. The file is written aside and renamed over path, so a crash never
+// leaves a torn snapshot behind. Returns false on an I/O error.
+bool saveSnapshot( const char path[], const Trip trip[], int n, int coordinates[CITIES][2],
+                   uint64_t seed, int generation );
+
+// Maps path and unpacks its n trips into trip[], its cities into coordinates.
+// seed and generation receive what was saved. Returns false if path cannot be
+// read or is not a snapshot of n trips of CITIES cities.
+bool loadSnapshot( const char path[], Trip trip[], int n, int coordinates[CITIES][2],
+                   uint64_t &seed, int &generation );
+
+#endif
@@ -0,0 +1,141 @@
+#include <string.h>  // memcpy
+#include <math.h>    // floorf
+#include <omp.h>     // OpenMP
+#include <algorithm> // sort
+#include "Timer.h"
+#include "Random.h"
+#include "Distances.h"
+#include "RunControl.h"
+#include "Solver.h"
+
+using namespace std;
+
+// EUC_2D distances of the instance: its Distances, rounded as TSPLIB does
+struct Euc2dDistance {
+  const Distances &dist;
+  float operator()( int a, int b ) const { return floorf( dist( a, b ) + 0.5f ); }
+};
+
+/*
+ * Length of the closed tour[0..n)
+ */
+static float length( const int tour[], int n, const Euc2dDistance &dist ) {
+  double sum = dist( tour[n - 1], tour[0] );
+  for ( int i = 1; i < n; i++ )
+    sum += dist( tour[i - 1], tour[i] );
+  return sum;
+}
+
+Solver::Solver( int population ) : population( population ), n( 0 ), fitness( population ),
+                                   ranking( population ) {
+}
+
+/*
+ * Ranks the slots by fitness, ties by slot, as Tsp's evaluate does
+ */
+void Solver::rank( ) {
+  for ( int i = 0; i < population; i++ ) {
+    uint32_t bits;
+    memcpy( &bits, &fitness[i], sizeof( bits ) );
+    ranking.keys[i] = ( uint64_t )bits << 32 | ( uint32_t )i;
+  }
+  sort( ranking.keys.begin( ), ranking.keys.end( ) );
+  for ( int r = 0; r < population; r++ )
+    ranking.order[r] = ( int )( uint32_t )ranking.keys[r];
+}
+
+/*
+ * Evolves a population of random tours of instance until options.generations
+ * or options.stall generations without a shorter tour, and returns the
+ * shortest tour in solution.
+ *
+ * Each generation, the best half of the population breeds pairwise into the
+ * slots of the worst half; every offspring is mutated at options.mutateRate
+ * and, with options.localSearch, improved to a local optimum.
+ */
+void Solver::solve( const Instance &instance, const SolverOptions &options, Solution &solution ) {
+  Timer timer;
+  timer.start( );
+
+  // the arena of this instance: only grows past the largest instance so far
+  n = instance.n;
+  tours.resize( ( size_t )population * n );
+  if ( ( int )crossoverBuffers.size( ) < options.threads ) {
+    crossoverBuffers.resize( options.threads, CrossoverBuffers( n ) );
+    localSearchBuffers.resize( options.threads, LocalSearchBuffers( n ) );
+  }
+  for ( int t = 0; t < options.threads; t++ ) {
+    crossoverBuffers[t].resize( n );
+    localSearchBuffers[t].resize( n );
+  }
+
+  Distances distances( n, instance.xy( ) );
+  Euc2dDistance dist = { distances };
+  NeighbourLists neighbours( n, LS_NEIGHBOURS, dist );
+  int nTop = population / 2;
+
+  // random tours, tour i from stream i
+  uint64_t initial = Random::derive( options.seed, ( uint64_t )-1 );
+  #pragma omp parallel num_threads( options.threads )
+  {
+    LocalSearchBuffers &buffers = localSearchBuffers[omp_get_thread_num( )];
+
+    #pragma omp for schedule( dynamic, 16 )
+    for ( int i = 0; i < population; i++ ) {
+      Random rng( initial, i );
+      int *path = tour( i );
+      for ( int c = 0; c < n; c++ )
+        path[c] = c;
+      for ( int c = n - 1; c > 0; c-- ) {
+        int r = rng.nextInt( c + 1 );
+        int temp = path[c]; path[c] = path[r]; path[r] = temp;
+      }
+      if ( options.localSearch )
+        improveTour( path, dist, neighbours, buffers );
+      fitness[i] = length( path, n, dist );
+    }
+  }
+
+  StoppingPolicy stopping;
+  stopping.stallLimit = options.stall;
+  int generation = 0;
+  for ( ; ; generation++ ) {
+    rank( );
+    if ( stopping.check( fitness[ranking.order[0]], 1, 0 ) != NULL || generation >= options.generations )
+      break;
+
+    // offsprings 2i and 2i + 1 draw from stream i of the generation's seed
+    uint64_t seed = Random::derive( options.seed, generation );
+    const int *parents = ranking.parents( ), *children = ranking.children( nTop );
+    #pragma omp parallel num_threads( options.threads )
+    {
+      CrossoverBuffers &xBuffers = crossoverBuffers[omp_get_thread_num( )];
+      LocalSearchBuffers &lsBuffers = localSearchBuffers[omp_get_thread_num( )];
+
+      #pragma omp for schedule( dynamic, 8 )
+      for ( int i = 0; i < nTop; i += 2 ) {
+        Random rng( seed, i );
+        for ( int k = 0; k < 2; k++ ) {
+          int *child = tour( children[i + k] );
+          crossoverChild( options.op, tour( parents[i + k] ), tour( parents[i + 1 - k] ), child,
+                          dist, rng, xBuffers );
+          if ( rng.nextInt( 100 ) < options.mutateRate ) {
+            int a = rng.nextInt( n );
+            int b = rng.nextInt( n - 1 );
+            if ( b >= a ) b++;
+            int temp = child[a]; child[a] = child[b]; child[b] = temp;
+          }
+          if ( options.localSearch )
+            improveTour( child, dist, neighbours, lsBuffers );
+          fitness[children[i + k]] = length( child, n, dist );
+        }
+      }
+    }
+  }
+
+  int *best = tour( ranking.order[0] );
+  solution.tour.assign( best, best + n );
+  solution.length = tourLength( instance, best );
+  solution.generations = generation;
+  solution.usec = timer.lap( );
+}
@@ -0,0 +1,69 @@
+#ifndef _SOLVER_H_
+#define _SOLVER_H_
+
+#include <stdint.h>
+#include <vector>
+#include "Crossover.h"
+#include "LocalSearch.h"
+#include "EvalXOverMutate.h"
+#include "Tsplib.h"
+
+using namespace std;
+
+// The GA of Tsp for a TSPLIB instance of any size: closed tours of city
+// indices instead of 36-letter itineraries, EUC_2D distances, and the same
+// crossover kernels, mutation and memetic 2-opt / Or-opt stage. As in Tsp,
+// every random choice comes from a ( seed, stream ) pair, so a seed gives
+// the same tour with any # threads.
+//
+// A Solver owns its population arena and per-thread scratch tables. They
+// grow to the largest instance seen so far and are reused by every later
+// solve, so solving many small instances allocates only on the first ones.
+
+#define SOLVER_POPULATION  1000   // tours per population (even)
+#define SOLVER_GENERATIONS 1000   // generations at most
+#define SOLVER_STALL       100    // generations without a shorter tour before stopping
+
+class SolverOptions {
+public:
+  SolverOptions( ) : seed( 1 ), threads( 1 ), generations( SOLVER_GENERATIONS ), stall( SOLVER_STALL ),
+                     op( XOVER_GREEDY ), mutateRate( MUTATE_RATE ), localSearch( false ) { }
+
+  uint64_t seed;
+  int threads;            // OpenMP threads of one solve
+  int generations;
+  int stall;              // 0: run all generations
+  CrossoverOperator op;
+  int mutateRate;         // % of offsprings with a pair of cities swapped
+  bool localSearch;       // improve every new tour to a 2-opt / Or-opt optimum
+};
+
+class Solution {
+public:
+  vector<int> tour;       // the shortest tour found, node indices 0..n-1
+  long length;            // its EUC_2D length
+  int generations;        // generations run
+  long usec;              // wall time of the solve
+};
+
+class Solver {
+public:
+  Solver( int population = SOLVER_POPULATION );
+
+  void solve( const Instance &instance, const SolverOptions &options, Solution &solution );
+
+  int population;
+
+private:
+  int n;                                 // # cities of the instance being solved
+  vector<int> tours;                     // tour of slot i at tours[i * n]
+  vector<float> fitness;                 // EUC_2D length of the tour of each slot
+  Ranking ranking;
+  vector<CrossoverBuffers> crossoverBuffers;       // one per thread
+  vector<LocalSearchBuffers> localSearchBuffers;   // one per thread
+
+  int *tour( int slot ) { return &tours[( size_t )slot * n]; }
+  void rank( );
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include <iostream>  // cout, cerr
+#include <fstream>   // ifstream
+#include <sstream>   // istringstream
+#include <string.h>  // strcmp
+#include <stdlib.h>  // atoi, atof, strtoull, exit
+#include <string>    // string
+#include <vector>    // vector
+#include <map>       // map
+#include "Timer.h"
+#include "Tsplib.h"
+#include "Solver.h"
+
+using namespace std;
+
+#define SUITE_FILE "instances/suite.txt"
+
+/*
+ * "1,2,4" as numbers; an empty list if any entry is not a positive number
+ */
+vector<uint64_t> parseList( const char list[] ) {
+  vector<uint64_t> values;
+  istringstream in( list );
+  string item;
+  while ( getline( in, item, ',' ) ) {
+    uint64_t value = strtoull( item.c_str( ), NULL, 10 );
+    if ( value == 0 )
+      return vector<uint64_t>( );
+    values.push_back( value );
+  }
+  return values;
+}
+
+#define MIN_BASELINE_USEC 1000000
+
+// Runs of an instance: the most generations/sec of one, as a busy machine
+// only ever slows a run down, and the usec of all
+struct Throughput {
+  double best, usec;
+};
+
+/*
+ * Adds the runs of each instance in path, an earlier output of Suite, to
+ * baseline; false if path cannot be read
+ */
+bool readBaseline( const char path[], map<string, Throughput> &baseline ) {
+  ifstream in( path );
+  if ( !in )
+    return false;
+  string line;
+  while ( getline( in, line ) ) {
+    istringstream fields( line );
+    string name, gap;
+    long n, optimum, length;
+    uint64_t seed, threads;
+    double usec, generations;
+    if ( !( fields >> name >> n >> optimum >> seed >> threads >> length >> gap >> usec >> generations ) )
+      continue;   // the header
+    Throughput &runs = baseline[name];
+    if ( usec > 0 && generations * 1000000.0 / usec > runs.best )
+      runs.best = generations * 1000000.0 / usec;
+    runs.usec += usec;
+  }
+  return true;
+}
+
+/*
+ * MAIN: usage: Suite [SUITE] [--seeds 1,2,3] [--threads 1,4] [--population N]
+ *                    [--generations N] [--stall N] [--crossover greedy|ox|pmx|erx|eax]
+ *                    [--local-search] [--max-gap PERCENT] [--baseline FILE [--slowdown PERCENT]]
+ *
+ * Runs the GA of Solver.h on every instance of SUITE (default instances/suite.txt)
+ * once per seed and # threads, and prints one tab-separated row per run:
+ *
+ *   instance  n  optimum  seed  threads  length  gap_percent  usec  generations  generations_per_sec
+ *
+ * gap_percent is "-" for an instance whose optimum is unknown. The exit
+ * status is 1, so that a script can catch quality, performance and
+ * determinism regressions, if
+ *   - a run is further above the optimum than the gap SUITE gives its
+ *     instance, or than --max-gap percent for all instances if given;
+ *   - the generations/sec of the fastest run of an instance fall more than
+ *     --slowdown percent (default 35, loose enough for a shared machine)
+ *     below those of its fastest run in FILE, the output of an earlier
+ *     Suite on the same machine ("Suite > baseline.tsv" records one).
+ *     Instances whose runs took under MIN_BASELINE_USEC in FILE are too
+ *     noisy to compare and skipped;
+ *   - one seed finds different tours with different # threads.
+ */
+int main( int argc, char* argv[] ) {
+  // default values
+  const char *suitePath = SUITE_FILE;
+  vector<uint64_t> seeds = parseList( "1,2,3" ), threads = parseList( "1,4" );
+  int population = SOLVER_POPULATION;
+  SolverOptions options;
+  double maxGap = -1;             // -1: the gaps of the suite
+  const char *baselinePath = NULL;
+  double slowdown = 35;
+
+  // argument verification
+  bool valid = true;
+  int nPositional = 0;
+  for ( int i = 1; i < argc && valid; i++ ) {
+    if ( strcmp( argv[i], "--seeds" ) == 0 && i + 1 < argc )
+      valid = !( seeds = parseList( argv[++i] ) ).empty( );
+    else if ( strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc )
+      valid = !( threads = parseList( argv[++i] ) ).empty( );
+    else if ( strcmp( argv[i], "--population" ) == 0 && i + 1 < argc )
+      valid = ( population = atoi( argv[++i] ) ) >= 4 && population % 2 == 0;
+    else if ( strcmp( argv[i], "--generations" ) == 0 && i + 1 < argc )
+      valid = ( options.generations = atoi( argv[++i] ) ) > 0;
+    else if ( strcmp( argv[i], "--stall" ) == 0 && i + 1 < argc )
+      valid = ( options.stall = atoi( argv[++i] ) ) >= 0;
+    else if ( strcmp( argv[i], "--crossover" ) == 0 && i + 1 < argc )
+      valid = ( options.op = parseCrossover( argv[++i] ) ) != XOVER_COUNT;
+    else if ( strcmp( argv[i], "--local-search" ) == 0 )
+      options.localSearch = true;
+    else if ( strcmp( argv[i], "--max-gap" ) == 0 && i + 1 < argc )
+      valid = ( maxGap = atof( argv[++i] ) ) >= 0;
+    else if ( strcmp( argv[i], "--baseline" ) == 0 && i + 1 < argc )
+      baselinePath = argv[++i];
+    else if ( strcmp( argv[i], "--slowdown" ) == 0 && i + 1 < argc )
+      valid = ( slowdown = atof( argv[++i] ) ) >= 0 && slowdown < 100;
+    else if ( argv[i][0] != '-' && nPositional++ == 0 )
+      suitePath = argv[i];
+    else
+      valid = false;
+  }
+  if ( !valid ) {
+    cerr << "usage: Suite [SUITE] [--seeds 1,2,3] [--threads 1,4] [--population N]" << endl
+         << "             [--generations N] [--stall N] [--crossover greedy|ox|pmx|erx|eax]" << endl
+         << "             [--local-search] [--max-gap PERCENT] [--baseline FILE [--slowdown PERCENT]]" << endl;
+    exit( -1 );
+  }
+  map<string, Throughput> baseline;
+  if ( baselinePath != NULL && !readBaseline( baselinePath, baseline ) ) {
+    cerr << "cannot read " << baselinePath << endl;
+    exit( -1 );
+  }
+
+  // instance paths are relative to the suite file
+  ifstream suite( suitePath );
+  if ( !suite ) {
+    cerr << "cannot read " << suitePath << endl;
+    exit( -1 );
+  }
+  string dir( suitePath );
+  dir = ( dir.rfind( '/' ) == string::npos ) ? "" : dir.substr( 0, dir.rfind( '/' ) + 1 );
+
+  cout << "instance\tn\toptimum\tseed\tthreads\tlength\tgap_percent\tusec\tgenerations\tgenerations_per_sec" << endl;
+  Solver solver( population );
+  Solution solution;
+  bool passed = true;
+  string line;
+  while ( getline( suite, line ) ) {
+    istringstream fields( line );
+    string file;
+    long optimum = 0;
+    double instanceGap = -1;
+    if ( !( fields >> file ) || file[0] == '#' )
+      continue;
+    fields >> optimum >> instanceGap;
+    if ( maxGap >= 0 )
+      instanceGap = maxGap;
+
+    Instance instance;
+    if ( !readTsplib( ( dir + file ).c_str( ), instance ) ) {
+      passed = false;
+      continue;
+    }
+
+    map<uint64_t, long> lengths;   // seed -> length found with the first # threads
+    Throughput throughput = { 0, 0 };
+    for ( size_t s = 0; s < seeds.size( ); s++ )
+      for ( size_t t = 0; t < threads.size( ); t++ ) {
+        options.seed = seeds[s];
+        options.threads = threads[t];
+        solver.solve( instance, options, solution );
+
+        double gap = ( optimum > 0 ) ? 100.0 * ( solution.length - optimum ) / optimum : 0;
+        cout << instance.name << "\t" << instance.n << "\t" << optimum << "\t" << seeds[s] << "\t"
+             << threads[t] << "\t" << solution.length << "\t";
+        if ( optimum > 0 )
+          cout << gap;
+        else
+          cout << "-";
+        cout << "\t" << solution.usec << "\t" << solution.generations << "\t"
+             << solution.generations * 1000000.0 / ( solution.usec > 0 ? solution.usec : 1 ) << endl;
+
+        if ( solution.usec > 0 && solution.generations * 1000000.0 / solution.usec > throughput.best )
+          throughput.best = solution.generations * 1000000.0 / solution.usec;
+        throughput.usec += solution.usec;
+
+        if ( instanceGap >= 0 && optimum > 0 && gap > instanceGap ) {
+          cerr << instance.name << " seed " << seeds[s] << ": gap " << gap << "% over " << instanceGap << "%" << endl;
+          passed = false;
+        }
+        if ( lengths.count( seeds[s] ) == 0 )
+          lengths[seeds[s]] = solution.length;
+        else if ( lengths[seeds[s]] != solution.length ) {
+          cerr << instance.name << " seed " << seeds[s] << ": " << threads[t]
+               << " threads found another tour than " << threads[0] << endl;
+          passed = false;
+        }
+      }
+
+    // best run against the baseline's
+    if ( baseline.count( instance.name ) && baseline[instance.name].usec >= MIN_BASELINE_USEC ) {
+      double before = baseline[instance.name].best;
+      double now = throughput.best;
+      if ( now < before * ( 1 - slowdown / 100 ) ) {
+        cerr << instance.name << ": " << now << " generations/sec, " << 100 * ( 1 - now / before )
+             << "% below the baseline's " << before << endl;
+        passed = false;
+      }
+    }
+  }
+  return passed ? 0 : 1;
+}
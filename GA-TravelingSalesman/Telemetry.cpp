@@ -0,0 +1,153 @@
+#include <iostream>  // cout
+#include <atomic>    // atomic
+#include <new>       // bad_alloc
+#include <stdlib.h>  // malloc, free
+#include <string.h>  // strlen, strcmp, memset
+#include "Telemetry.h"
+
+using namespace std;
+
+Telemetry telemetry;
+
+#if TELEMETRY
+
+static const char *phaseNames[PHASE_COUNT] = { "evaluate", "rank", "crossover", "mutate", "improve", "checkpoint" };
+
+// Heap allocations of the whole process, counted by the global operator new
+static atomic<long> allocationCount( 0 );
+
+void *operator new( size_t size ) {
+  allocationCount.fetch_add( 1, memory_order_relaxed );
+  void *p = malloc( size > 0 ? size : 1 );
+  if ( p == NULL )
+    throw bad_alloc( );
+  return p;
+}
+
+void operator delete( void *p ) noexcept {
+  free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept {
+  free( p );
+}
+
+/*
+ * Opens path and writes the CSV header, or the opening bracket of the JSON array
+ */
+bool Telemetry::open( const char path[] ) {
+  file = fopen( path, "w" );
+  if ( file == NULL ) {
+    cout << "telemetry: cannot write " << path << endl;
+    return false;
+  }
+  size_t len = strlen( path );
+  json = len >= 5 && strcmp( path + len - 5, ".json" ) == 0;
+  if ( json )
+    fprintf( file, "[\n" );
+  else {
+    fprintf( file, "generation,elapsed_usec" );
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      fprintf( file, ",%s_usec", phaseNames[p] );
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      if ( p != PHASE_RANK && p != PHASE_CHECKPOINT )
+        fprintf( file, ",%s_imbalance", phaseNames[p] );
+    fprintf( file, ",evaluated,best,mean,diversity,allocations\n" );
+  }
+  active = true;
+  first = true;
+  generation = -1;
+  opened = omp_get_wtime( );
+  return true;
+}
+
+void Telemetry::close( ) {
+  if ( file == NULL )
+    return;
+  if ( json )
+    fprintf( file, "\n]\n" );
+  fclose( file );
+  file = NULL;
+  active = false;
+}
+
+void Telemetry::startGeneration( int generation ) {
+  if ( !active )
+    return;
+  this->generation = generation;
+  evaluated = 0;
+  best = mean = diversity = 0;
+  memset( wall, 0, sizeof( wall ) );
+  memset( busy, 0, sizeof( busy ) );
+  allocations = allocationCount.load( memory_order_relaxed );
+}
+
+/*
+ * Records the population's statistics after evaluate
+ */
+void Telemetry::population( const Trip trip[], const Ranking &ranking, int evaluated ) {
+  if ( !active )
+    return;
+  this->evaluated = evaluated;
+  int n = ranking.n;
+  double sum = 0;
+  for ( int i = 0; i < n; i++ )
+    sum += trip[i].fitness;
+  mean = sum / n;
+
+  best = trip[ranking.order[0]].fitness;
+  diversity = ::diversity( trip, ranking );
+}
+
+/*
+ * Writes the generation's record. Evaluate's wall time excludes the ranking
+ * it includes, which has its own column. Imbalance is the busiest thread's
+ * time over the mean thread time (1 = perfectly balanced).
+ */
+void Telemetry::endGeneration( ) {
+  if ( !active )
+    return;
+  long allocated = allocationCount.load( memory_order_relaxed ) - allocations;
+  long elapsed = ( long )( ( omp_get_wtime( ) - opened ) * 1e6 );
+  double usec[PHASE_COUNT], imbalance[PHASE_COUNT];
+  int nThreads = omp_get_max_threads( );
+  if ( nThreads > TELEMETRY_THREADS ) nThreads = TELEMETRY_THREADS;
+  for ( int p = 0; p < PHASE_COUNT; p++ ) {
+    usec[p] = ( wall[p] - ( p == PHASE_EVALUATE ? wall[PHASE_RANK] : 0 ) ) * 1e6;
+    double most = 0, total = 0;
+    for ( int t = 0; t < nThreads; t++ ) {
+      total += busy[t].seconds[p];
+      most = ( busy[t].seconds[p] > most ) ? busy[t].seconds[p] : most;
+    }
+    imbalance[p] = ( total > 0 ) ? most * nThreads / total : 1;
+  }
+
+  if ( json ) {
+    fprintf( file, "%s  {\"generation\": %d, \"elapsed_usec\": %ld", first ? "" : ",\n", generation, elapsed );
+    first = false;
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      fprintf( file, ", \"%s_usec\": %.1f", phaseNames[p], usec[p] );
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      if ( p != PHASE_RANK && p != PHASE_CHECKPOINT )
+        fprintf( file, ", \"%s_imbalance\": %.3f", phaseNames[p], imbalance[p] );
+    fprintf( file, ", \"evaluated\": %d, \"best\": %.3f, \"mean\": %.3f, \"diversity\": %.4f, \"allocations\": %ld}",
+             evaluated, best, mean, diversity, allocated );
+  } else {
+    fprintf( file, "%d,%ld", generation, elapsed );
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      fprintf( file, ",%.1f", usec[p] );
+    for ( int p = 0; p < PHASE_COUNT; p++ )
+      if ( p != PHASE_RANK && p != PHASE_CHECKPOINT )
+        fprintf( file, ",%.3f", imbalance[p] );
+    fprintf( file, ",%d,%.3f,%.3f,%.4f,%ld\n", evaluated, best, mean, diversity, allocated );
+  }
+}
+
+#else
+
+bool Telemetry::open( const char path[] ) {
+  cout << "telemetry: not built in (compiled with -DTELEMETRY=0)" << endl;
+  return false;
+}
+
+#endif
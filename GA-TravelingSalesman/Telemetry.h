@@ -0,0 +1,91 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdio.h>   // FILE
+#include <omp.h>     // omp_get_wtime, omp_get_thread_num
+#include "Trip.h"
+#include "EvalXOverMutate.h"
+
+// Per-generation telemetry of the panmictic GA: wall time per phase, the
+// load imbalance of each phase's threads, best / mean distance, diversity,
+// and heap allocations. One record per generation goes to a CSV file, or to
+// a JSON array when the file name ends in ".json".
+//
+// Build with -DTELEMETRY=0 to compile the collector and all of its probes
+// out; the operators then carry no timing code at all.
+
+#ifndef TELEMETRY
+#define TELEMETRY 1
+#endif
+
+#define TELEMETRY_THREADS 256   // threads whose busy time is kept apart
+
+enum Phase { PHASE_EVALUATE, PHASE_RANK, PHASE_CROSSOVER, PHASE_MUTATE, PHASE_IMPROVE,
+             PHASE_CHECKPOINT, PHASE_COUNT };
+
+#if TELEMETRY
+
+class Telemetry {
+public:
+  Telemetry( ) : active( false ), file( NULL ) { }
+
+  bool open( const char path[] );    // starts recording; false if path cannot be written
+  void close( );
+
+  void startGeneration( int generation );
+  void start( Phase phase ) { if ( active ) began[phase] = omp_get_wtime( ); }
+  void stop( Phase phase ) { if ( active ) wall[phase] += omp_get_wtime( ) - began[phase]; }
+
+  // Busy time of the calling thread in phase, from inside a parallel region
+  void threadBusy( Phase phase, double seconds ) {
+    int thread = omp_get_thread_num( );
+    if ( active && thread < TELEMETRY_THREADS )
+      busy[thread].seconds[phase] += seconds;   // own slot: no sharing
+  }
+
+  // Best / mean distance and diversity of the ranked population
+  void population( const Trip trip[], const Ranking &ranking, int evaluated );
+  void endGeneration( );
+
+  bool active;
+
+private:
+  FILE *file;
+  bool json, first;                  // first: no record written yet
+  int generation, evaluated;
+  double opened;                     // wall time of open, for the elapsed time
+  double began[PHASE_COUNT], wall[PHASE_COUNT];
+  struct alignas( 64 ) ThreadBusy { double seconds[PHASE_COUNT]; } busy[TELEMETRY_THREADS];
+  float best, mean, diversity;
+  long allocations;                  // allocation count at the start of the generation
+};
+
+// Times the calling thread's share of a parallel phase
+#define TELEMETRY_THREAD_START( ) double telemetryStart = omp_get_wtime( )
+#define TELEMETRY_THREAD_STOP( phase ) telemetry.threadBusy( phase, omp_get_wtime( ) - telemetryStart )
+
+#else
+
+class Telemetry {
+public:
+  Telemetry( ) : active( false ) { }
+  bool open( const char path[] );
+  void close( ) { }
+  void startGeneration( int generation ) { }
+  void start( Phase phase ) { }
+  void stop( Phase phase ) { }
+  void threadBusy( Phase phase, double seconds ) { }
+  void population( const Trip trip[], const Ranking &ranking, int evaluated ) { }
+  void endGeneration( ) { }
+  bool active;
+};
+
+#define TELEMETRY_THREAD_START( )
+#define TELEMETRY_THREAD_STOP( phase )
+
+#endif
+
+// The one collector of the process
+extern Telemetry telemetry;
+
+#endif
@@ -5,7 +5,7 @@
 #define CITIES         36    // 36 cities = ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789   (DO NOT CHANGE)
 #define MAX_GENERATION 150   //                                                    (DO NOT CHANGE)
 #define TOP_X          25000 // top 50%                                            (DO NOT CHANGE)
-#define MUTATE_RATE    50    // 50% for time being                                 (YOU MAY CHANGE IT)
+#define MUTATE_RATE    52    // about 50%, tuned                                    (YOU MAY CHANGE IT)
                                                                     
 #define DEBUG          false // for debugging   
 
@@ -13,7 +13,8 @@
 class Trip {
 public:
   char itinerary[CITIES + 1];  // a route through all 36 cities from (0, 0) 
-  float fitness;               // the distance of this entire route
+  double fitness;              // the distance of this entire route: the sum of its float edges
+  bool dirty;                  // itinerary changed since fitness was computed
 };
 
 #endif
@@ -3,104 +3,341 @@
 #include <string.h>  // strncpy
 #include <stdlib.h>  // rand
 #include <math.h>    // sqrt, pow
+#include <time.h>    // time
 #include <omp.h>     // OpenMP
 #include "Timer.h"
 #include "Trip.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "EvalXOverMutate.h"
+#include "Island.h"
+#include "Distributed.h"
+#include "Snapshot.h"
+#include "Telemetry.h"
+#include "RunControl.h"
+#include "Batch.h"
 
 using namespace std;
 
 // Already implemented. see the actual implementations below
 void initialize( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] );
-void select( Trip trip[CHROMOSOMES], Trip parents[TOP_X] );
-void populate( Trip trip[CHROMOSOMES], Trip offsprings[TOP_X] );
 
-// need to implement for your program 1
-extern void evaluate( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] );
-extern void crossover( Trip parents[TOP_X], Trip offsprings[TOP_X], int coordinates[CITIES][2] );
-extern void mutate( Trip offsprings[TOP_X] );
+// need to implement for your program 1: see EvalXOverMutate.h
 
 /*
- * MAIN: usage: Tsp #threads
+ * MAIN: usage: Tsp #threads [--seed N] [--crossover greedy|ox|pmx|erx|eax] [--local-search]
+ *                  [--islands N] [--coordinator ADDRESS --workers N | --worker ADDRESS]
+ *                  [--checkpoint N] [--resume] [--telemetry FILE]
+ *                  [--stall N] [--target DISTANCE] [--time-budget SEC] [--min-diversity D]
+ *                  [--adaptive-mutation] [--batch | --serve ADDRESS]
+ *
+ * The same seed reproduces the same run bit-for-bit regardless of # threads.
+ * --local-search adds a memetic stage: offsprings are improved by 2-opt / Or-opt.
+ * --islands splits the population into N islands that evolve independently
+ * and exchange elites (see Island.h); each island needs a thread of its own,
+ * so N may not exceed #threads.
+ * --coordinator / --worker spread the islands over processes connected by a
+ * Unix-domain socket path or loopback ":port" (see Distributed.h).
+ * --checkpoint saves the population to checkpoint.bin every N generations, and
+ * --resume continues the run saved there, with its seed (see Snapshot.h).
+ * --telemetry records every generation to FILE, as CSV or as JSON if FILE
+ * ends in ".json" (see Telemetry.h).
+ * --stall, --target, --time-budget and --min-diversity stop the run before
+ * MAX_GENERATION after N generations without a shorter trip, at a trip of at
+ * most DISTANCE, before SEC seconds would be exceeded, or once the diversity
+ * falls under D. --adaptive-mutation raises the mutation rate while the
+ * shortest trip stalls (see RunControl.h).
+ * --batch solves a stream of TSPLIB instances from stdin with #threads
+ * workers instead, and --serve does so for every connection at ADDRESS; of
+ * the options above, they take --seed, --crossover, --local-search and
+ * --stall (see Batch.h).
  */
 int main( int argc, char* argv[] ) {
   Trip trip[CHROMOSOMES];       // all 50000 different trips (or chromosomes)
   Trip shortest;                // the shortest path so far
   int coordinates[CITIES][2];   // (x, y) coordinates of all 36 cities:
   int nThreads = 1;
+  uint64_t seed = time( NULL );
+  CrossoverOperator op = XOVER_GREEDY;
+  bool localSearch = false;
+  int nIslands = 0;             // 0: one panmictic population
+  const char* coordinator = NULL; // address to coordinate workers at
+  const char* worker = NULL;      // address of the coordinator to work for
+  int nWorkers = 0;
+  int checkpoint = 0;           // generations between two checkpoints, 0: none
+  bool resume = false;
+  int firstGeneration = 0;
+  const char* telemetryFile = NULL;
+  StoppingPolicy stopping;
+  bool adaptiveMutation = false;
+  bool batch = false;           // solve TSPLIB instances from stdin
+  const char* serve = NULL;     // address to solve TSPLIB instances at
   
   // verify the arguments
-  if ( argc == 2 )
-    nThreads = atoi( argv[1] );
-  else {
-    cout << "usage: Tsp #threads" << endl;
-    if ( argc != 1 )
+  bool valid = true;
+  int nPositional = 0;
+  for ( int i = 1; i < argc; i++ ) {
+    if ( strcmp( argv[i], "--seed" ) == 0 && i + 1 < argc )
+      seed = strtoull( argv[++i], NULL, 10 );
+    else if ( strcmp( argv[i], "--crossover" ) == 0 && i + 1 < argc )
+      valid = ( op = parseCrossover( argv[++i] ) ) != XOVER_COUNT && valid;
+    else if ( strcmp( argv[i], "--local-search" ) == 0 )
+      localSearch = true;
+    else if ( strcmp( argv[i], "--islands" ) == 0 && i + 1 < argc )
+      valid = ( nIslands = atoi( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--coordinator" ) == 0 && i + 1 < argc )
+      coordinator = argv[++i];
+    else if ( strcmp( argv[i], "--workers" ) == 0 && i + 1 < argc )
+      valid = ( nWorkers = atoi( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--worker" ) == 0 && i + 1 < argc )
+      worker = argv[++i];
+    else if ( strcmp( argv[i], "--checkpoint" ) == 0 && i + 1 < argc )
+      valid = ( checkpoint = atoi( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--resume" ) == 0 )
+      resume = true;
+    else if ( strcmp( argv[i], "--telemetry" ) == 0 && i + 1 < argc )
+      telemetryFile = argv[++i];
+    else if ( strcmp( argv[i], "--stall" ) == 0 && i + 1 < argc )
+      valid = ( stopping.stallLimit = atoi( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--target" ) == 0 && i + 1 < argc )
+      valid = ( stopping.target = atof( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--time-budget" ) == 0 && i + 1 < argc )
+      valid = ( stopping.budget = ( long )( atof( argv[++i] ) * 1000000 ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--min-diversity" ) == 0 && i + 1 < argc )
+      valid = ( stopping.minDiversity = atof( argv[++i] ) ) > 0 && valid;
+    else if ( strcmp( argv[i], "--adaptive-mutation" ) == 0 )
+      adaptiveMutation = true;
+    else if ( strcmp( argv[i], "--batch" ) == 0 )
+      batch = true;
+    else if ( strcmp( argv[i], "--serve" ) == 0 && i + 1 < argc )
+      serve = argv[++i];
+    else if ( argv[i][0] != '-' && nPositional++ == 0 )
+      nThreads = atoi( argv[i] );
+    else
+      valid = false;
+  }
+  if ( coordinator != NULL && ( nWorkers == 0 || worker != NULL ) )
+    valid = false;
+  // one thread per island at least
+  if ( nIslands > nThreads )
+    valid = false;
+  // only the panmictic loop checkpoints, records telemetry and stops early
+  bool panmictic = checkpoint > 0 || resume || telemetryFile != NULL || adaptiveMutation
+    || stopping.stallLimit > 0 || stopping.target > 0 || stopping.budget > 0 || stopping.minDiversity > 0;
+  if ( panmictic && ( nIslands > 0 || coordinator != NULL || worker != NULL ) )
+    valid = false;
+  // batch mode has its own instances and generation loop
+  if ( ( batch || serve != NULL ) && ( batch == ( serve != NULL ) || nIslands > 0 || coordinator != NULL
+       || worker != NULL || checkpoint > 0 || resume || telemetryFile != NULL || adaptiveMutation
+       || stopping.target > 0 || stopping.budget > 0 || stopping.minDiversity > 0 || nThreads < 1 ) )
+    valid = false;
+  if ( !valid || argc == 1 ) {
+    cout << "usage: Tsp #threads [--seed N] [--crossover greedy|ox|pmx|erx|eax] [--local-search]"
+         << " [--islands N] [--coordinator ADDRESS --workers N | --worker ADDRESS]"
+         << " [--checkpoint N] [--resume] [--telemetry FILE]"
+         << " [--stall N] [--target DISTANCE] [--time-budget SEC] [--min-diversity D]"
+         << " [--adaptive-mutation] [--batch | --serve ADDRESS]" << endl;
+    if ( !valid )
       return -1; // wrong arguments
   }
-  cout << "# threads = " << nThreads << endl;
+
+  // batch mode: stdout carries the results only
+  if ( batch || serve != NULL ) {
+    SolverOptions options;
+    options.seed = seed;
+    options.op = op;
+    options.localSearch = localSearch;
+    if ( stopping.stallLimit > 0 )
+      options.stall = stopping.stallLimit;
+    return runBatch( serve, nThreads, options );
+  }
+  cout << "# threads = " << nThreads << ", seed = " << seed
+       << ", crossover = " << crossoverNames[op]
+       << ", local search = " << ( localSearch ? "on" : "off" )
+       << ", islands = " << nIslands << endl;
+
+  // the coordinator only relays migrants between the workers
+  if ( coordinator != NULL )
+    return runCoordinator( coordinator, nWorkers, seed );
 
   // shortest path not yet initialized
   shortest.itinerary[CITIES] = 0;  // null path
   shortest.fitness = -1.0;         // invalid distance
 
-  // initialize 5000 trips and 36 cities' coordinates
-  initialize( trip, coordinates );
+  // initialize 5000 trips and 36 cities' coordinates, or take them over
+  // from the last checkpoint
+  if ( !resume )
+    initialize( trip, coordinates );
+  else if ( loadSnapshot( CHECKPOINT_FILE, trip, CHROMOSOMES, coordinates, seed, firstGeneration ) )
+    cout << "resumed from " << CHECKPOINT_FILE << " at generation " << firstGeneration
+         << ", seed = " << seed << endl;
+  else {
+    cout << "no checkpoint to resume from: " << CHECKPOINT_FILE << endl;
+    return -1;
+  }
+
+  // distances between the cities and from (0, 0), shared by all operators
+  Distances distances( CITIES, coordinates, true );
 
   // start a timer 
   Timer timer;
   timer.start( );
 
+  // time spent in each phase of a generation, and # trips evaluated
+  enum { EVALUATE, CROSSOVER, MUTATE, IMPROVE, CHECKPOINT, PHASES };
+  const char* phaseNames[PHASES] = { "evaluate", "crossover", "mutate", "improve", "checkpoint" };
+  long phaseTime[PHASES] = { 0 };
+  long evaluated[PHASES] = { 0 };
+  Timer phase;
+
   // change # of threads
   omp_set_num_threads( nThreads );
 
+  // worker mode: islands of this process' share of the trips
+  if ( worker != NULL )
+    return runWorker( worker, trip, distances, nIslands, nThreads, op, localSearch );
+
+  // island mode: the islands run the whole generation loop themselves
+  if ( nIslands > 0 ) {
+    evolveIslands( trip, CHROMOSOMES, distances, nIslands, nThreads, seed, op, localSearch, shortest );
+    long elapsed = timer.lap( );
+    cout << "shortest distance = " << shortest.fitness
+         << "\t itinerary = " << shortest.itinerary << endl;
+    cout << "elapsed time = " << elapsed << endl;
+    cout << "generations/sec = " << MAX_GENERATION * 1000000.0 / elapsed << endl;
+    return 0;
+  }
+
+  // trips stay in their slots; ranking.order[] lists them from the shortest.
+  // The TOP_X parents are the first ranks and their offsprings replace the
+  // last TOP_X ranks in place, so parents and offsprings never overlap.
+  Ranking ranking( CHROMOSOMES );
+  const int *parents = ranking.parents( );
+  const int *children = ranking.children( TOP_X );
+  if ( telemetryFile != NULL && !telemetry.open( telemetryFile ) )
+    return -1;
+  MutationControl mutation( MUTATE_RATE, adaptiveMutation );
+  int lastGeneration = MAX_GENERATION - 1;
+
   // find the shortest path in each generation
-  for ( int generation = 0; generation < MAX_GENERATION; generation++ ) {
+  for ( int generation = firstGeneration; generation < MAX_GENERATION; generation++ ) {
 
-    // evaluate the distance of all 50000 trips
-    evaluate( trip, coordinates );
+    // evaluate the distance of all changed trips out of 50000 and rank them
+    telemetry.startGeneration( generation );
+    phase.start( );
+    telemetry.start( PHASE_EVALUATE );
+    int evaluatedNow = evaluate( trip, ranking, distances );
+    telemetry.stop( PHASE_EVALUATE );
+    phaseTime[EVALUATE] += phase.lap( );
+    evaluated[EVALUATE] += evaluatedNow;
+    telemetry.population( trip, ranking, evaluatedNow );
 
     // just print out the progress
     if ( generation % 20 == 0 )
       cout << "generation: " << generation << endl;
 
     // whenever a shorter path was found, update the shortest path
-    if ( shortest.fitness < 0 || shortest.fitness > trip[0].fitness ) {
+    const Trip &best = trip[ranking.order[0]];
+    if ( shortest.fitness < 0 || shortest.fitness > best.fitness ) {
 
-      strncpy( shortest.itinerary, trip[0].itinerary, CITIES );
-      shortest.fitness = trip[0].fitness;
+      strncpy( shortest.itinerary, best.itinerary, CITIES );
+      shortest.fitness = best.fitness;
 
       cout << "generation: " << generation 
 	   << " shortest distance = " << shortest.fitness
 	   << "\t itinerary = " << shortest.itinerary << endl;
     }
 
-    // define TOP_X parents and offsprings.
-    Trip parents[TOP_X], offsprings[TOP_X];
-
-    // choose TOP_X parents from trip
-    select( trip, parents );
+    // decide whether this is the last generation; its offsprings still
+    // complete the population, so that a checkpoint can continue the run
+    const char *stop = stopping.check( best.fitness,
+                                       stopping.needsDiversity( ) ? diversity( trip, ranking ) : 1,
+                                       timer.lap( ) );
 
-    // generates TOP_X offsprings from TOP_X parenets
-    crossover( parents, offsprings, coordinates );
+    // generates TOP_X offsprings from the TOP_X best trips, straight into
+    // the slots of the TOP_X worst ones (this populates the next generation)
+    // (each generation and phase draws from its own seed derived from the master seed)
+    phase.start( );
+    telemetry.start( PHASE_CROSSOVER );
+    evaluated[CROSSOVER] += crossover( trip, parents, children, distances, Random::derive( seed, 2 * generation ), op );
+    telemetry.stop( PHASE_CROSSOVER );
+    phaseTime[CROSSOVER] += phase.lap( );
 
     // mutate offsprings
-    mutate( offsprings );
+    phase.start( );
+    telemetry.start( PHASE_MUTATE );
+    evaluated[MUTATE] += mutate( trip, children, distances, Random::derive( seed, 2 * generation + 1 ), TOP_X,
+                                 mutation.update( stopping.stalled ) );
+    telemetry.stop( PHASE_MUTATE );
+    phaseTime[MUTATE] += phase.lap( );
+
+    // improve offsprings to local optima
+    phase.start( );
+    telemetry.start( PHASE_IMPROVE );
+    if ( localSearch )
+      improve( trip, children, distances );
+    telemetry.stop( PHASE_IMPROVE );
+    phaseTime[IMPROVE] += phase.lap( );
+
+    // save the next generation's population
+    phase.start( );
+    telemetry.start( PHASE_CHECKPOINT );
+    if ( checkpoint > 0 && ( generation + 1 ) % checkpoint == 0 )
+      saveSnapshot( CHECKPOINT_FILE, trip, CHROMOSOMES, coordinates, seed, generation + 1 );
+    telemetry.stop( PHASE_CHECKPOINT );
+    phaseTime[CHECKPOINT] += phase.lap( );
+    telemetry.endGeneration( );
 
-    // populate the next generation.
-    populate( trip, offsprings );
+    // for debugging
+    if ( DEBUG ) {
+      for ( int chrom = 0; chrom < CHROMOSOMES; chrom++ )
+        cout << "chrom[" << chrom << "] = " << trip[chrom].itinerary
+             << ", trip distance = " << trip[chrom].fitness << endl;
+    }
+
+    if ( stop != NULL ) {
+      cout << "generation: " << generation << " stopped: " << stop
+           << ", mutation rate = " << mutation.rate << endl;
+      lastGeneration = generation;
+      break;
+    }
   }
 
   // stop a timer
-  cout << "elapsed time = " << timer.lap( ) << endl;
+  long elapsed = timer.lap( );
+  telemetry.close( );
+  int generations = lastGeneration + 1 - firstGeneration;
+  if ( generations == 0 )
+    return 0;
+  cout << "elapsed time = " << elapsed << endl;
+  cout << "generations/sec = " << generations * 1000000.0 / elapsed << endl;
+
+  // generation-time breakdown
+  for ( int i = 0; i < PHASES; i++ )
+    cout << phaseNames[i] << " = " << phaseTime[i] / generations << " usec/generation" << endl;
+  // every trip evaluated, wherever it was: against one full evaluation per trip and generation
+  long total = 0;
+  for ( int i = 0; i < PHASES; i++ )
+    total += evaluated[i];
+  cout << "trips evaluated = " << total << " of " << ( long )CHROMOSOMES * generations << endl;
+  for ( int i = EVALUATE; i <= MUTATE; i++ )
+    cout << "  in " << phaseNames[i] << " = " << evaluated[i] << endl;
   return 0;
 }
 
 /*
- * Initializes trip[CHROMOSOMES] with chromosome.txt and coordiantes[CITIES][2] with cities.txt
+ * Initializes trip[CHROMOSOMES] and coordiantes[CITIES][2] with chromosome.bin
+ * if initialize wrote one, or else with chromosome.txt and cities.txt
  *
  * @param trip[CHROMOSOMES]:      50000 different trips
  * @param coordinates[CITIES][2]: (x, y) coordinates of 36 different cities: ABCDEFGHIJKLMNOPQRSTUVWXYZ
  */
 void initialize( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] ) {
+  uint64_t seed;
+  int generation;
+  if ( loadSnapshot( POPULATION_FILE, trip, CHROMOSOMES, coordinates, seed, generation ) )
+    return;
+
   // open two files to read chromosomes (i.e., trips)  and cities
   ifstream chromosome_file( "chromosome.txt" );
   ifstream cities_file( "cities.txt" );
@@ -113,6 +350,7 @@ void initialize( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] ) {
   for ( int i = 0; i < CHROMOSOMES; i++ ) {
     chromosome_file >> trip[i].itinerary;
     trip[i].fitness = 0.0;
+    trip[i].dirty = true;
   }
 
   // cities.txt:                                                                                               
@@ -139,31 +377,3 @@ void initialize( Trip trip[CHROMOSOMES], int coordinates[CITIES][2] ) {
       cout << coordinates[i][0] << "\t" << coordinates[i][1] << endl;
   }
 }
-
-/*
- * Select the first TOP_X parents from trip[CHROMOSOMES]
- *
- * @param trip[CHROMOSOMES]: all trips
- * @param parents[TOP_X]:    the firt TOP_X parents
- */
-void select( Trip trip[CHROMOSOMES], Trip parents[TOP_X] ) {
-  // just copy TOP_X trips to parents
-  for ( int i = 0; i < TOP_X; i++ )
-    strncpy( parents[i].itinerary, trip[i].itinerary, CITIES + 1 );
-}
-
-/*
- * Replace the bottom TOP_X trips with the TOP_X offsprings
- */
-void populate( Trip trip[CHROMOSOMES], Trip offsprings[TOP_X] ) {
-  // just copy TOP_X offsprings to the bottom TOP_X trips.
-  for ( int i = 0; i < TOP_X; i++ )
-    strncpy( trip[ CHROMOSOMES - TOP_X + i ].itinerary, offsprings[i].itinerary, CITIES + 1 );
-
-  // for debugging
-  if ( DEBUG ) {
-    for ( int chrom = 0; chrom < CHROMOSOMES; chrom++ ) 
-      cout << "chrom[" << chrom << "] = " << trip[chrom].itinerary 
-	   << ", trip distance = " << trip[chrom].fitness << endl;
-  }
-}
@@ -0,0 +1,121 @@
+#include <iostream>  // cerr
+#include <stdio.h>   // fopen, fgets, sscanf
+#include <string.h>  // strcmp, strchr, strspn
+#include <stdlib.h>  // atoi
+#include "Tsplib.h"
+
+using namespace std;
+
+/*
+ * Splits "KEY : VALUE" (or a bare "KEY") into key and value, without blanks.
+ * Returns false for a blank line.
+ */
+static bool keyValue( char line[], char *&key, char *&value ) {
+  key = line + strspn( line, " \t" );
+  char *end = key + strlen( key );
+  while ( end > key && strchr( " \t\r\n", end[-1] ) )
+    *--end = 0;
+  if ( *key == 0 )
+    return false;
+  value = end;
+  char *colon = strchr( key, ':' );
+  if ( colon != NULL ) {
+    value = colon + 1 + strspn( colon + 1, " \t" );
+    do
+      *colon-- = 0;
+    while ( colon >= key && strchr( " \t", *colon ) );
+  }
+  return true;
+}
+
+/*
+ * Skips the rest of an instance that cannot be read, up to its EOF line
+ */
+static void skipInstance( FILE *in ) {
+  char line[1024], *key, *value;
+  while ( fgets( line, sizeof( line ), in ) != NULL )
+    if ( keyValue( line, key, value ) && strcmp( key, "EOF" ) == 0 )
+      return;
+}
+
+bool readTsplib( FILE *in, Instance &instance, string &error ) {
+  instance.name.clear( );
+  instance.n = 0;
+  instance.coordinates.clear( );
+  error.clear( );
+
+  char line[1024], *key, *value;
+  bool any = false, ended = false, euc2d = false;   // ended: read up to the EOF line
+  while ( fgets( line, sizeof( line ), in ) != NULL ) {
+    if ( !keyValue( line, key, value ) )
+      continue;
+    any = true;
+    if ( ( ended = strcmp( key, "EOF" ) == 0 ) )
+      break;
+    else if ( strcmp( key, "NAME" ) == 0 )
+      instance.name = value;
+    else if ( strcmp( key, "TYPE" ) == 0 && strcmp( value, "TSP" ) != 0 )
+      error = string( "TYPE " ) + value + " is not a symmetric TSP";
+    else if ( strcmp( key, "DIMENSION" ) == 0 )
+      instance.n = atoi( value );
+    else if ( strcmp( key, "EDGE_WEIGHT_TYPE" ) == 0 )
+      euc2d = strcmp( value, "EUC_2D" ) == 0;
+    else if ( strcmp( key, "NODE_COORD_SECTION" ) == 0 ) {
+      if ( error.empty( ) && !euc2d )
+        error = "EDGE_WEIGHT_TYPE is not EUC_2D";
+      if ( error.empty( ) && instance.n < 3 )
+        error = "DIMENSION is missing or below 3";
+      if ( !error.empty( ) )
+        break;
+
+      // "id x y" per node, ids 1..n in any order
+      instance.coordinates.assign( 2 * instance.n, 0.0 );
+      vector<char> seen( instance.n, 0 );
+      for ( int i = 0; i < instance.n && error.empty( ); i++ ) {
+        int id;
+        double x, y;
+        if ( fgets( line, sizeof( line ), in ) == NULL || sscanf( line, "%d %lf %lf", &id, &x, &y ) != 3 )
+          error = "NODE_COORD_SECTION ends before DIMENSION nodes";
+        else if ( id < 1 || id > instance.n || seen[id - 1]++ )
+          error = "node ids are not 1..DIMENSION";
+        else {
+          instance.coordinates[2 * ( id - 1 )] = x;
+          instance.coordinates[2 * ( id - 1 ) + 1] = y;
+        }
+      }
+      if ( !error.empty( ) )
+        break;
+    }
+  }
+  if ( !any )
+    return false;    // nothing but blanks up to the end of the input
+  if ( error.empty( ) && instance.coordinates.empty( ) )
+    error = "no NODE_COORD_SECTION";
+  if ( !error.empty( ) ) {
+    if ( !ended )
+      skipInstance( in );
+    return false;
+  }
+  return true;
+}
+
+bool readTsplib( const char path[], Instance &instance ) {
+  FILE *in = fopen( path, "r" );
+  if ( in == NULL ) {
+    cerr << "cannot read " << path << endl;
+    return false;
+  }
+  string error;
+  bool ok = readTsplib( in, instance, error );
+  fclose( in );
+  if ( !ok )
+    cerr << path << ": " << ( error.empty( ) ? "empty" : error.c_str( ) ) << endl;
+  return ok;
+}
+
+long tourLength( const Instance &instance, const int tour[] ) {
+  long length = 0;
+  for ( int i = 0; i < instance.n; i++ )
+    length += euc2d( instance, tour[i], tour[( i + 1 ) % instance.n] );
+  return length;
+}
@@ -0,0 +1,43 @@
+#ifndef _TSPLIB_H_
+#define _TSPLIB_H_
+
+#include <stdio.h>   // FILE
+#include <math.h>    // sqrt
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Symmetric TSP instances in TSPLIB format. Only what EUC_2D instances need is
+// read: NAME, DIMENSION, EDGE_WEIGHT_TYPE and the NODE_COORD_SECTION, up to
+// an EOF line or the end of the input. Other keywords are skipped.
+
+typedef double Point[2];
+
+class Instance {
+public:
+  string name;
+  int n;                        // # nodes
+  vector<double> coordinates;   // node i at ( coordinates[2i], coordinates[2i + 1] )
+
+  const Point *xy( ) const { return ( const Point * )&coordinates[0]; }   // for Distances
+};
+
+// Reads the next instance from in. Returns false at the end of the input, or
+// with why in error if the instance is not an EUC_2D one.
+bool readTsplib( FILE *in, Instance &instance, string &error );
+
+// Reads the instance in path; prints why and returns false if it cannot
+bool readTsplib( const char path[], Instance &instance );
+
+// TSPLIB's EUC_2D distance: the Euclidean distance rounded to the nearest integer
+inline int euc2d( const Instance &instance, int a, int b ) {
+  double dx = instance.coordinates[2 * a] - instance.coordinates[2 * b];
+  double dy = instance.coordinates[2 * a + 1] - instance.coordinates[2 * b + 1];
+  return ( int )( sqrt( dx * dx + dy * dy ) + 0.5 );
+}
+
+// Length of the closed tour[0..n) in EUC_2D distances
+long tourLength( const Instance &instance, const int tour[] );
+
+#endif
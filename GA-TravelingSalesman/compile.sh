@@ -1,9 +1,21 @@
 #!/bin/sh
+# TELEMETRY=0 ./compile.sh builds without the per-generation telemetry probes
 
-g++ initialize.cpp -o initialize
-g++ -c EvalXOverMutate.cpp -fopenmp
-g++ -c Timer.cpp
-g++ Tsp.cpp Timer.o EvalXOverMutate.o -fopenmp -o Tsp
+T=-DTELEMETRY=${TELEMETRY:-1}
+
+g++ -O2 -c Timer.cpp
+g++ -O2 -c Snapshot.cpp -fopenmp
+g++ -O2 initialize.cpp Timer.o Snapshot.o -fopenmp -o initialize
+g++ -O2 $T -c EvalXOverMutate.cpp -fopenmp
+g++ -O2 $T -c Telemetry.cpp -fopenmp
+g++ -O2 -c Island.cpp -fopenmp
+g++ -O2 -c Distributed.cpp -fopenmp
+g++ -O2 -c Tsplib.cpp
+g++ -O2 -c Solver.cpp -fopenmp
+g++ -O2 -c Batch.cpp -fopenmp
+g++ -O2 $T Tsp.cpp Timer.o EvalXOverMutate.o Telemetry.o Island.o Distributed.o Snapshot.o Tsplib.o Solver.o Batch.o -fopenmp -o Tsp
+g++ -O2 $T Bench.cpp Timer.o EvalXOverMutate.o Telemetry.o Snapshot.o -fopenmp -o Bench
+g++ -O2 Suite.cpp Timer.o Tsplib.o Solver.o -fopenmp -o Suite
 
 
 
@@ -1,156 +1,218 @@
 #include <iostream>  // cout
-#include <fstream>   // ofstream
-#include <string.h>  // strncmp
-#include <stdlib.h>  // rand
+#include <string.h>  // strncpy, strcmp, memcmp
+#include <stdio.h>   // fopen, fwrite, remove
+#include <stdlib.h>  // atoi, strtoull, exit
+#include <vector>    // vector
+#include <string>    // string
+#include <algorithm> // fill
+#include <omp.h>     // OpenMP
+#include "Timer.h"
+#include "Random.h"
+#include "Snapshot.h"
 
 #define CHROMOSOMES    50000 // 50000
 #define CITIES         36    // Cities = ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789
 #define DEBUG          false // for debugging
 
+#define LINE           ( CITIES + 1 )  // a trip and its '\n' in chromosome.txt
+
 using namespace std;
 
-char getCity( );
-void initialize( char trip[][CITIES + 1], int coordinates[CITIES][2], 
-		 int nChromosomes );
+void initialize( char trips[], int coordinates[CITIES][2], int nChromosomes, uint64_t seed );
 
+/*
+ * MAIN: usage: initialize nChromosomes [--binary] [--seed N]
+ *
+ * Writes nChromosomes different random trips to chromosome.txt (or
+ * chromosome.bin with --binary, see Snapshot.h) and 36 different random
+ * cities to cities.txt. The same seed always writes the same files,
+ * regardless of # threads.
+ */
 int main( int argc, char* argv[] ) {
   // default values
   int nChromosomes = CHROMOSOMES;
+  bool binary = false;    // chromosome.bin instead of chromosome.txt
+  uint64_t seed = 1;
 
   // argument verification
-  if ( argc == 2 ) {
-    nChromosomes = atoi( argv[1] );
+  bool valid = true;
+  int nPositional = 0;
+  for ( int i = 1; i < argc; i++ ) {
+    if ( strcmp( argv[i], "--binary" ) == 0 )
+      binary = true;
+    else if ( strcmp( argv[i], "--seed" ) == 0 && i + 1 < argc )
+      seed = strtoull( argv[++i], NULL, 10 );
+    else if ( argv[i][0] != '-' && nPositional++ == 0 )
+      valid = ( nChromosomes = atoi( argv[i] ) ) > 0;
+    else
+      valid = false;
   }
-  else {
-    cout << "usage: initialize nChromosomes" << endl;
-    if ( argc != 1 )
+  if ( !valid || argc == 1 ) {
+    cout << "usage: initialize nChromosomes [--binary] [--seed N]" << endl;
+    if ( !valid )
       exit( -1 );
   }
-  cout << "# chromosomes = " << nChromosomes 
-       << ", # cities = " << CITIES << endl;
-
-  // declare chromosomes and cities
-  char trip[nChromosomes][CITIES + 1];
-  int coordinates[CITIES][2]; 
+  cout << "# chromosomes = " << nChromosomes
+       << ", # cities = " << CITIES << ", seed = " << seed
+       << ", # threads = " << omp_get_max_threads( ) << endl;
 
-  // open two files to store chromosomes and cities
-  ofstream chromosome_file( "chromosome.txt" );
-  ofstream cities_file( "cities.txt" );
+  // declare chromosomes, as the very lines of chromosome.txt, and cities
+  vector<char> trips( ( size_t )nChromosomes * LINE );
+  int coordinates[CITIES][2];
 
   // initialize chormosomes and cities
-  initialize( trip, coordinates, nChromosomes );
-  
-  // write data to the two files
-  // chromosome.txt:
-  //   T8JHFKM7BO5XWYSQ29IP04DL6NU3ERVA1CZG
-  //   FWLXU2DRSAQEVYOBCPNI608194ZHJM73GK5T
-  //   HU93YL0MWAQFIZGNJCRV12TO75BPE84S6KXD
-  for ( int i = 0; i < nChromosomes; i++ )
-    chromosome_file << trip[i] << endl;
-
-  // cities.txt:
+  Timer timer;
+  timer.start( );
+  initialize( &trips[0], coordinates, nChromosomes, seed );
+  long generateTime = timer.lap( );
+
+  timer.start( );
+  if ( binary ) {
+    // chromosome.bin: the trips, unevaluated, and the cities (see Snapshot.h)
+    vector<Trip> trip( nChromosomes );
+    #pragma omp parallel for
+    for ( int i = 0; i < nChromosomes; i++ ) {
+      strncpy( trip[i].itinerary, &trips[( size_t )i * LINE], CITIES );
+      trip[i].itinerary[CITIES] = 0;
+      trip[i].fitness = 0.0;
+      trip[i].dirty = true;
+    }
+    if ( !saveSnapshot( POPULATION_FILE, &trip[0], nChromosomes, coordinates, seed, 0 ) )
+      exit( -1 );
+  }
+  else {
+    // Tsp prefers chromosome.bin: do not leave a stale one behind
+    remove( POPULATION_FILE );
+
+    // chromosome.txt, in one write:
+    //   T8JHFKM7BO5XWYSQ29IP04DL6NU3ERVA1CZG
+    //   FWLXU2DRSAQEVYOBCPNI608194ZHJM73GK5T
+    //   HU93YL0MWAQFIZGNJCRV12TO75BPE84S6KXD
+    FILE *chromosome_file = fopen( "chromosome.txt", "wb" );
+    if ( chromosome_file == NULL || fwrite( &trips[0], LINE, nChromosomes, chromosome_file ) != ( size_t )nChromosomes ) {
+      cout << "cannot write chromosome.txt" << endl;
+      exit( -1 );
+    }
+    fclose( chromosome_file );
+  }
+
+  // cities.txt, written in both cases:
   // name    x       y
   // A       83      99
   // B       77      35
   // C       14      64
-  for ( int i = 0; i < CITIES; i++ ) {
+  FILE *cities_file = fopen( "cities.txt", "w" );
+  for ( int i = 0; cities_file != NULL && i < CITIES; i++ ) {
     char city_name = ( i < 26 ) ? i + 'A' : i - 26 + '0';
-    cities_file << city_name 
-		<< "\t" << coordinates[i][0] << "\t" << coordinates[i][1] 
-		<< endl;
+    fprintf( cities_file, "%c\t%d\t%d\n", city_name, coordinates[i][0], coordinates[i][1] );
   }
+  if ( cities_file != NULL )
+    fclose( cities_file );
+  long writeTime = timer.lap( );
 
-  // close the files.
-  chromosome_file.close( );
-  cities_file.close( );
-    
+  cout << "generate = " << generateTime << " usec, write = " << writeTime << " usec" << endl;
   return 0;
 }
 
 /*
- * Returns a randome city name, one of: ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789
+ * Writes a random trip to line[0..CITIES) by a Fisher-Yates shuffle, and its '\n'
+ */
+void shuffleTrip( char line[], Random &rng ) {
+  for ( int c = 0; c < CITIES; c++ )
+    line[c] = ( c < 26 ) ? c + 'A' : c - 26 + '0';
+  for ( int c = CITIES - 1; c > 0; c-- ) {
+    int r = rng.nextInt( c + 1 );
+    char temp = line[c];
+    line[c] = line[r];
+    line[r] = temp;
+  }
+  line[CITIES] = '\n';
+}
+
+/*
+ * FNV-1a hash of a trip
  */
-char getCity( ) {
-  char city = rand( ) % CITIES;
-  if ( city < 26 )
-    city += 'A';
-  else
-    city = city - 26 + '0';
-  return city;
+uint64_t hashTrip( const char line[] ) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for ( int c = 0; c < CITIES; c++ )
+    h = ( h ^ ( unsigned char )line[c] ) * 0x100000001B3ULL;
+  return h;
 }
 
 /*
  * Initialize nChoromosomes number of trips and nCities of coordinates.
  *
- * @param trip:         all chromosomes to be initialized
+ * Trip i is shuffled from stream i of seed, in parallel. Duplicates are then
+ * found in one pass over an open-addressing hash table, and the later copy is
+ * shuffled again from a fresh stream until no trip repeats.
+ *
+ * @param trips:        all chromosomes to be initialized, LINE chars each
  * @param coordinates:  all cities to be initialized for x and y
  * @param nChromosomes: # of chromosomes
+ * @param seed:         seed of all random choices
  */
-void initialize( char trip[][CITIES + 1], int coordinates[CITIES][2], 
-		 int nChromosomes ) {
+void initialize( char trips[], int coordinates[CITIES][2], int nChromosomes, uint64_t seed ) {
   // initialize chromosomes
+  #pragma omp parallel for schedule( static )
   for ( int chrom = 0; chrom < nChromosomes; chrom++ ) {
+    Random rng( seed, chrom );
+    shuffleTrip( &trips[( size_t )chrom * LINE], rng );
+  }
 
-    // show the progress
-    if ( chrom % 10000 == 0 )
-      cout << chrom << " initialized" << endl;
-
-    // add the very last delimiter
-    trip[chrom][CITIES] = 0;
-    
-    while ( true ) {
-      // initialize each trip
-      for ( int cities = 0; cities < CITIES; cities++ ) {
-	while ( true ) {
-	  char candidate = getCity( );
-	  
-	  // check if there is the same city
-	  if ( cities > 0 ) {
-	    for ( int prev = 0; prev < cities; prev++ )
-	      if ( trip[chrom][prev] == candidate ) {
-		// found the same city on the route
-		candidate = 0; // make it void
-		break;
-	      }
-	  }
-
-	  if ( candidate != 0 ) {
-	    trip[chrom][cities] = candidate;
-	    break;          // go to the next city
-	  }
-	  // else get another city
-	}
+  // hash table of chromosome indices + 1, at most half full
+  size_t size = 2;
+  while ( size < 2 * ( size_t )nChromosomes )
+    size *= 2;
+  vector<int> table( size );
+  vector<uint64_t> hashes( nChromosomes );
+  vector<int> duplicates;
+  for ( uint64_t attempt = 1; ; attempt++ ) {
+    #pragma omp parallel for schedule( static )
+    for ( int chrom = 0; chrom < nChromosomes; chrom++ )
+      hashes[chrom] = hashTrip( &trips[( size_t )chrom * LINE] );
+
+    // check if there is the same trip
+    fill( table.begin( ), table.end( ), 0 );
+    duplicates.clear( );
+    for ( int chrom = 0; chrom < nChromosomes; chrom++ ) {
+      size_t slot = hashes[chrom] & ( size - 1 );
+      for ( ; table[slot] != 0; slot = ( slot + 1 ) & ( size - 1 ) ) {
+        int prev = table[slot] - 1;
+        if ( hashes[prev] == hashes[chrom]
+             && memcmp( &trips[( size_t )prev * LINE], &trips[( size_t )chrom * LINE], CITIES ) == 0 )
+          break;
       }
-      
-      // check if there is the same trip
-      bool found = false;
-      if ( chrom > 0 ) {
-	for ( int prev = 0; prev < chrom; prev++ )
-	  if ( found = ( strncmp( trip[prev], trip[chrom], CITIES ) == 0 ) ) {
-	    break;
-	  }
-      }
-      if ( found )
-	continue;        // get another trip
+      if ( table[slot] != 0 )
+        duplicates.push_back( chrom );   // found the same trip
       else
-	break;           // go to the next trip
+        table[slot] = chrom + 1;
     }
+    if ( duplicates.empty( ) )
+      break;
 
-    if ( DEBUG ) 
-      cout << "chrom[" << chrom << "] = " << trip[chrom] << endl;
+    // get another trip for each duplicate
+    for ( size_t i = 0; i < duplicates.size( ); i++ ) {
+      Random rng( seed, attempt * nChromosomes + duplicates[i] );
+      shuffleTrip( &trips[( size_t )duplicates[i] * LINE], rng );
+    }
   }
 
+  if ( DEBUG )
+    for ( int chrom = 0; chrom < nChromosomes; chrom++ )
+      cout << "chrom[" << chrom << "] = " << string( &trips[( size_t )chrom * LINE], CITIES ) << endl;
+
   // initialize each city's x and y coordinates
+  Random rng( seed, ( uint64_t )-1 );
   for ( int cities = 0; cities < CITIES; cities++ ) {
     while ( true ) {
-      coordinates[cities][0] = rand( ) % 100;
-      coordinates[cities][1] = rand( ) % 100;
+      coordinates[cities][0] = rng.nextInt( 100 );
+      coordinates[cities][1] = rng.nextInt( 100 );
 
       // check if there is the same coordiante
       bool found = false;
       if ( cities > 0 ) {
 	for ( int prev = 0; prev < cities; prev++ )
-	  if ( found = ( coordinates[prev][0] == coordinates[cities][0] && 
+	  if ( found = ( coordinates[prev][0] == coordinates[cities][0] &&
 			 coordinates[prev][1] == coordinates[cities][1] ) )
 	    // found the same coordinate
 	    break;
@@ -161,11 +223,10 @@ void initialize( char trip[][CITIES + 1], int coordinates[CITIES][2],
 	break;    // go to the next city
     }
     if ( DEBUG )
-      cout << "coordinates[" 
-	   << ( char )( ( cities < 26 ) ? cities + 'A' : cities - 26 + '0' ) 
+      cout << "coordinates["
+	   << ( char )( ( cities < 26 ) ? cities + 'A' : cities - 26 + '0' )
 	   << "] = ("
-	   << coordinates[cities][0] << ", " << coordinates[cities][1] << ")" 
+	   << coordinates[cities][0] << ", " << coordinates[cities][1] << ")"
 	   << endl;
   }
 }
-
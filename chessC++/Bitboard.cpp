@@ -0,0 +1,135 @@
+#include "Bitboard.h"
+
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard pawnAttacks[2][64];
+Bitboard betweenSquares[64][64];
+
+Magic bishopMagics[64];
+Magic rookMagics[64];
+
+// Attack sets of all squares; every square has 2^(bits of its mask) of them
+static Bitboard bishopTable[5248];
+static Bitboard rookTable[102400];
+
+static const int rookDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static const int bishopDirections[4][2] = {{-1, -1}, {1, 1}, {-1, 1}, {1, -1}};
+
+static bool isOnBoard(int r, int c){
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+// Attacks along the four rays of directions, each ray stopping at its first blocker
+static Bitboard slidingAttacks(int sq, Bitboard occupied, const int directions[4][2]){
+    Bitboard attacks = 0;
+    for(int i = 0; i < 4; i++){
+        int r = sq / 8 + directions[i][0];
+        int c = sq % 8 + directions[i][1];
+        while(isOnBoard(r, c)){
+            attacks |= squareBB(r * 8 + c);
+            if(occupied & squareBB(r * 8 + c)) break;
+            r += directions[i][0];
+            c += directions[i][1];
+        }
+    }
+    return attacks;
+}
+
+// The squares of the rays whose occupancy changes the attacks: all but the last of each ray
+static Bitboard relevantMask(int sq, const int directions[4][2]){
+    Bitboard mask = 0;
+    for(int i = 0; i < 4; i++){
+        int r = sq / 8 + directions[i][0];
+        int c = sq % 8 + directions[i][1];
+        while(isOnBoard(r + directions[i][0], c + directions[i][1])){
+            mask |= squareBB(r * 8 + c);
+            r += directions[i][0];
+            c += directions[i][1];
+        }
+    }
+    return mask;
+}
+
+// The magics are searched with a fixed seed, so every run finds the same ones
+uint64_t nextRandom(uint64_t &state){
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// Finds a magic for every square and fills its attack sets from table on
+static void initMagics(Magic magics[64], Bitboard *table, const int directions[4][2]){
+    Bitboard occupancies[4096], references[4096];
+    int epoch[4096] = {0}, attempt = 0;
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    for(int sq = 0; sq < 64; sq++){
+        Magic &m = magics[sq];
+        m.mask = relevantMask(sq, directions);
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = table;
+
+        // every subset of the mask (carry-rippler) and its attacks
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancies[size] = subset;
+            references[size++] = slidingAttacks(sq, subset, directions);
+            subset = (subset - m.mask) & m.mask;
+        } while(subset);
+
+        // sparse random candidates until one maps no two subsets with different attacks together
+        for(bool found = false; !found; ){
+            do {
+                m.magic = nextRandom(state) & nextRandom(state) & nextRandom(state);
+            } while(popCount((m.mask * m.magic) >> 56) < 6);
+
+            attempt++;
+            found = true;
+            for(int i = 0; i < size && found; i++){
+                unsigned index = (unsigned)((occupancies[i] * m.magic) >> m.shift);
+                if(epoch[index] < attempt){
+                    epoch[index] = attempt;
+                    table[index] = references[i];
+                } else if(table[index] != references[i]){
+                    found = false;
+                }
+            }
+        }
+        table += size;
+    }
+}
+
+void initBitboards(){
+    for(int sq = 0; sq < 64; sq++){
+        int r = sq / 8, c = sq % 8;
+        knightAttacks[sq] = kingAttacks[sq] = 0;
+        pawnAttacks[0][sq] = pawnAttacks[1][sq] = 0;
+        for(int dr = -2; dr <= 2; dr++){
+            for(int dc = -2; dc <= 2; dc++){
+                if(!isOnBoard(r + dr, c + dc)) continue;
+                Bitboard to = squareBB((r + dr) * 8 + c + dc);
+                if(dr * dr + dc * dc == 5) knightAttacks[sq] |= to;
+                if((dr || dc) && dr * dr <= 1 && dc * dc <= 1) kingAttacks[sq] |= to;
+                if(dr == -1 && dc * dc == 1) pawnAttacks[0][sq] |= to;
+                if(dr == 1 && dc * dc == 1) pawnAttacks[1][sq] |= to;
+            }
+        }
+    }
+    initMagics(bishopMagics, bishopTable, bishopDirections);
+    initMagics(rookMagics, rookTable, rookDirections);
+
+    // the rays of two aligned squares towards each other meet between them
+    for(int a = 0; a < 64; a++){
+        for(int b = 0; b < 64; b++){
+            betweenSquares[a][b] = 0;
+            if(a == b) continue;
+            if(rookAttacks(a, 0) & squareBB(b)){
+                betweenSquares[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            } else if(bishopAttacks(a, 0) & squareBB(b)){
+                betweenSquares[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
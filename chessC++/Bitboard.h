@@ -0,0 +1,62 @@
+#ifndef _BITBOARD_H_
+#define _BITBOARD_H_
+
+#include <stdint.h>
+
+// A set of squares, one bit per square. Squares are numbered as in the
+// board[64] array: 0 = a8 ... 7 = h8, 56 = a1 ... 63 = h1, so bit i stands
+// for board[i]. Row 0 is the 8th rank, and white pawns move towards it.
+typedef uint64_t Bitboard;
+
+inline Bitboard squareBB(int sq) { return 1ULL << sq; }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+
+// Returns the lowest square of b and removes it from b
+inline int popLsb(Bitboard &b){
+    int sq = __builtin_ctzll(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Attacks of the leapers from each square
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard pawnAttacks[2][64]; // [0] white pawn, [1] black pawn on the square
+
+// Squares strictly between two squares on one rank, file or diagonal; 0 if not aligned
+extern Bitboard betweenSquares[64][64];
+
+// Sliding attacks by magic bitboards: the blockers on the piece's rays
+// (mask) are hashed by a multiplication into a table of attack sets.
+struct Magic {
+    Bitboard mask;      // squares whose occupancy matters, board edges excluded
+    Bitboard magic;
+    Bitboard *attacks;  // 1 << (64 - shift) attack sets
+    int shift;
+};
+
+extern Magic bishopMagics[64];
+extern Magic rookMagics[64];
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied){
+    const Magic &m = bishopMagics[sq];
+    return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied){
+    const Magic &m = rookMagics[sq];
+    return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied){
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+// Fills all tables; call once before generating any move
+void initBitboards();
+
+// xorshift64*: from a fixed seed, the same numbers every run
+uint64_t nextRandom(uint64_t &state);
+
+#endif
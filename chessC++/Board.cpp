@@ -0,0 +1,428 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "Board.h"
+
+using namespace std;
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_H 0x8080808080808080ULL
+#define RANK_8 0x00000000000000FFULL  // row 0
+#define RANK_7 0x000000000000FF00ULL
+#define RANK_2 0x00FF000000000000ULL
+#define RANK_1 0xFF00000000000000ULL  // row 7
+
+uint64_t zobristPieces[16][64];
+uint64_t zobristCastling[16];
+uint64_t zobristEnPassant[8];
+uint64_t zobristSide;
+
+int pieceSquareMg[16][64];
+int pieceSquareEg[16][64];
+
+void initZobrist(){
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for(int piece = 0; piece < 16; piece++){
+        for(int sq = 0; sq < 64; sq++) zobristPieces[piece][sq] = nextRandom(state);
+    }
+    for(int i = 0; i < 16; i++) zobristCastling[i] = nextRandom(state);
+    for(int i = 0; i < 8; i++) zobristEnPassant[i] = nextRandom(state);
+    zobristSide = nextRandom(state);
+}
+
+// Castling rights left after a move from or to a square: a king or rook
+// leaving home, or a rook captured at home, ends them
+static int castlingKept(int sq){
+    switch(sq){
+    case 60: return ALL_CASTLING & ~(1 << WHITE_KING_SIDE | 1 << WHITE_QUEEN_SIDE);
+    case 63: return ALL_CASTLING & ~(1 << WHITE_KING_SIDE);
+    case 56: return ALL_CASTLING & ~(1 << WHITE_QUEEN_SIDE);
+    case 4:  return ALL_CASTLING & ~(1 << BLACK_KING_SIDE | 1 << BLACK_QUEEN_SIDE);
+    case 7:  return ALL_CASTLING & ~(1 << BLACK_KING_SIDE);
+    case 0:  return ALL_CASTLING & ~(1 << BLACK_QUEEN_SIDE);
+    default: return ALL_CASTLING;
+    }
+}
+
+void Board::clear(){
+    memset(pieces, 0, sizeof(pieces));
+    colors[0] = colors[1] = occupied = 0;
+    memset(squares, 0, sizeof(squares));
+    side = WHITE;
+    castling = 0;
+    epSquare = -1;
+    key = 0;
+    psqMg = psqEg = 0;
+}
+
+void Board::put(int sq, int piece){
+    Bitboard b = squareBB(sq);
+    pieces[piece] |= b;
+    colors[colorIndex(getColor(piece))] |= b;
+    occupied |= b;
+    squares[sq] = piece;
+    key ^= zobristPieces[piece][sq];
+    psqMg += pieceSquareMg[piece][sq];
+    psqEg += pieceSquareEg[piece][sq];
+}
+
+void Board::remove(int sq){
+    Bitboard b = squareBB(sq);
+    int piece = squares[sq];
+    pieces[piece] &= ~b;
+    colors[colorIndex(getColor(piece))] &= ~b;
+    occupied &= ~b;
+    squares[sq] = EMPTY;
+    key ^= zobristPieces[piece][sq];
+    psqMg -= pieceSquareMg[piece][sq];
+    psqEg -= pieceSquareEg[piece][sq];
+}
+
+void Board::sync(){
+    memset(pieces, 0, sizeof(pieces));
+    colors[0] = colors[1] = occupied = 0;
+    psqMg = psqEg = 0;
+    for(int sq = 0; sq < 64; sq++){
+        if(squares[sq]) put(sq, squares[sq]);
+    }
+    key = computeKey();
+}
+
+uint64_t Board::computeKey() const {
+    uint64_t res = zobristCastling[castling];
+    for(int sq = 0; sq < 64; sq++){
+        if(squares[sq]) res ^= zobristPieces[squares[sq]][sq];
+    }
+    if(epSquare >= 0) res ^= zobristEnPassant[epSquare & 7];
+    if(side == BLACK) res ^= zobristSide;
+    return res;
+}
+
+Bitboard Board::attacksBy(int color) const {
+    Bitboard pawns = pieces[color | PAWN];
+    Bitboard attacks = (color == WHITE)
+        ? ((pawns & ~FILE_A) >> 9) | ((pawns & ~FILE_H) >> 7)
+        : ((pawns & ~FILE_A) << 7) | ((pawns & ~FILE_H) << 9);
+
+    for(Bitboard b = pieces[color | KNIGHT]; b; ) attacks |= knightAttacks[popLsb(b)];
+    for(Bitboard b = pieces[color | BISHOP] | pieces[color | QUEEN]; b; ) attacks |= bishopAttacks(popLsb(b), occupied);
+    for(Bitboard b = pieces[color | ROOK] | pieces[color | QUEEN]; b; ) attacks |= rookAttacks(popLsb(b), occupied);
+    attacks |= kingAttacks[lsb(pieces[color | KING])];
+    return attacks;
+}
+
+Bitboard Board::attackersTo(int sq, int color, Bitboard occupied) const {
+    // a pawn of color attacks sq from where a pawn of the other color on sq would attack
+    return (pawnAttacks[colorIndex(color ^ BLACK)][sq] & pieces[color | PAWN])
+         | (knightAttacks[sq] & pieces[color | KNIGHT])
+         | (kingAttacks[sq] & pieces[color | KING])
+         | (bishopAttacks(sq, occupied) & (pieces[color | BISHOP] | pieces[color | QUEEN]))
+         | (rookAttacks(sq, occupied) & (pieces[color | ROOK] | pieces[color | QUEEN]));
+}
+
+Bitboard Board::pinned(int color) const {
+    int them = color ^ BLACK;
+    int king = lsb(pieces[color | KING]);
+    Bitboard snipers = (rookAttacks(king, 0) & (pieces[them | ROOK] | pieces[them | QUEEN]))
+                     | (bishopAttacks(king, 0) & (pieces[them | BISHOP] | pieces[them | QUEEN]));
+    Bitboard res = 0;
+    while(snipers){
+        Bitboard blockers = betweenSquares[king][popLsb(snipers)] & occupied;
+        if(popCount(blockers) == 1) res |= blockers & colors[colorIndex(color)];
+    }
+    return res;
+}
+
+// Adds a pawn move, as the four promotions when it reaches the last rank
+static void addPawnMove(int from, int to, int flags, int captured, MoveList &moves){
+    if(squareBB(to) & (RANK_1 | RANK_8)){
+        moves.add(MOVE(from, to, QUEEN, flags, captured));
+        moves.add(MOVE(from, to, ROOK, flags, captured));
+        moves.add(MOVE(from, to, BISHOP, flags, captured));
+        moves.add(MOVE(from, to, KNIGHT, flags, captured));
+    } else {
+        moves.add(MOVE(from, to, 0, flags, captured));
+    }
+}
+
+static void addMoves(int from, Bitboard targets, const uint8_t *squares, MoveList &moves){
+    while(targets){
+        int to = popLsb(targets);
+        moves.add(MOVE(from, to, 0, squares[to] ? MOVE_CAPTURE : 0, squares[to]));
+    }
+}
+
+void Board::generateMoves(MoveList &moves) const {
+    int us = side, them = side ^ BLACK;
+    Bitboard own = colors[colorIndex(us)];
+    Bitboard enemy = colors[colorIndex(them)];
+
+    // Pawns: one or two squares forward, captures including en passant
+    int forward = (us == WHITE) ? -8 : 8;
+    Bitboard startRow = (us == WHITE) ? RANK_2 : RANK_7;
+    for(Bitboard b = pieces[us | PAWN]; b; ){
+        int from = popLsb(b);
+        int to = from + forward;
+        if(!(occupied & squareBB(to))){
+            addPawnMove(from, to, 0, EMPTY, moves);
+            if((startRow & squareBB(from)) && !(occupied & squareBB(to + forward))){
+                moves.add(MOVE(from, to + forward, 0, MOVE_DOUBLE_PUSH, EMPTY));
+            }
+        }
+        for(Bitboard t = pawnAttacks[colorIndex(us)][from] & enemy; t; ){
+            to = popLsb(t);
+            addPawnMove(from, to, MOVE_CAPTURE, squares[to], moves);
+        }
+        if(epSquare >= 0 && (pawnAttacks[colorIndex(us)][from] & squareBB(epSquare))){
+            moves.add(MOVE(from, epSquare, 0, MOVE_CAPTURE | MOVE_EN_PASSANT, them | PAWN));
+        }
+    }
+
+    for(Bitboard b = pieces[us | KNIGHT]; b; ){
+        int from = popLsb(b);
+        addMoves(from, knightAttacks[from] & ~own, squares, moves);
+    }
+    for(Bitboard b = pieces[us | BISHOP] | pieces[us | QUEEN]; b; ){
+        int from = popLsb(b);
+        addMoves(from, bishopAttacks(from, occupied) & ~own, squares, moves);
+    }
+    for(Bitboard b = pieces[us | ROOK] | pieces[us | QUEEN]; b; ){
+        int from = popLsb(b);
+        addMoves(from, rookAttacks(from, occupied) & ~own, squares, moves);
+    }
+    int king = lsb(pieces[us | KING]);
+    addMoves(king, kingAttacks[king] & ~own, squares, moves);
+
+    // Castling: rights kept, squares between king and rook empty, and the
+    // king neither in check nor passing or landing on an attacked square
+    int kingSide = (us == WHITE) ? WHITE_KING_SIDE : BLACK_KING_SIDE;
+    int queenSide = (us == WHITE) ? WHITE_QUEEN_SIDE : BLACK_QUEEN_SIDE;
+    int home = (us == WHITE) ? 60 : 4;
+    bool canKingSide = (castling & (1 << kingSide)) && !(occupied & (squareBB(home + 1) | squareBB(home + 2)));
+    bool canQueenSide = (castling & (1 << queenSide))
+        && !(occupied & (squareBB(home - 1) | squareBB(home - 2) | squareBB(home - 3)));
+    if((canKingSide || canQueenSide) && !isSquareAttacked(home, them)){
+        if(canKingSide && !isSquareAttacked(home + 1, them) && !isSquareAttacked(home + 2, them)){
+            moves.add(MOVE(home, home + 2, 0, MOVE_CASTLING, EMPTY));
+        }
+        if(canQueenSide && !isSquareAttacked(home - 1, them) && !isSquareAttacked(home - 2, them)){
+            moves.add(MOVE(home, home - 2, 0, MOVE_CASTLING, EMPTY));
+        }
+    }
+}
+
+// A pseudo-legal move is legal unless it leaves the king attacked. Only
+// king moves and en passant need a look at the board after the move:
+//  - a pinned piece must stay on the line through its king and its pinner
+//  - in check, any other piece must take the checker or step in between
+//  - in double check, only the king may move
+void Board::generateLegalMoves(MoveList &moves) const {
+    int first = moves.size();
+    generateMoves(moves);
+
+    int us = side, them = side ^ BLACK;
+    int king = lsb(pieces[us | KING]);
+    Bitboard checkers = attackersTo(king, them, occupied);
+    Bitboard pins = pinned(us);
+    Bitboard evasions = ~0ULL;
+    if(checkers) evasions = (popCount(checkers) > 1) ? 0 : checkers | betweenSquares[king][lsb(checkers)];
+
+    int kept = first;
+    for(int i = first; i < moves.size(); i++){
+        Move move = moves[i];
+        int from = MOVE_FROM(move), to = MOVE_TO(move);
+        bool legal;
+        if(from == king){
+            // castling is checked by generateMoves; a king may not stay on the line of a slider it steps away from
+            legal = (MOVE_FLAGS(move) & MOVE_CASTLING) || !attackersTo(to, them, occupied ^ squareBB(king));
+        } else if(MOVE_FLAGS(move) & MOVE_EN_PASSANT){
+            // two pieces leave the rank of the king at once
+            Board next = *this;
+            legal = next.makeMove(move);
+        } else {
+            legal = (squareBB(to) & evasions)
+                && (!(pins & squareBB(from))
+                    || (betweenSquares[king][to] & squareBB(from))
+                    || (betweenSquares[king][from] & squareBB(to)));
+        }
+        if(legal) moves[kept++] = move;
+    }
+    moves.resize(kept);
+}
+
+Move Board::encodeMove(int from, int to, int promotion) const {
+    int piece = squares[from];
+    int flags = squares[to] ? MOVE_CAPTURE : 0, captured = squares[to];
+    if(getPiece(piece) == PAWN && to == epSquare && getColor(piece) == side){
+        flags = MOVE_CAPTURE | MOVE_EN_PASSANT;
+        captured = squares[to + (side == WHITE ? 8 : -8)];
+    }
+    if(getPiece(piece) == PAWN && abs(to - from) == 16) flags |= MOVE_DOUBLE_PUSH;
+    if(getPiece(piece) == KING && abs(to - from) == 2) flags |= MOVE_CASTLING;
+    return MOVE(from, to, promotion, flags, captured);
+}
+
+bool Board::makeMove(Move move){
+    int from = MOVE_FROM(move), to = MOVE_TO(move), promotion = MOVE_PROMOTION(move);
+    int flags = MOVE_FLAGS(move);
+    int us = side;
+    int piece = squares[from];
+
+    if(epSquare >= 0) key ^= zobristEnPassant[epSquare & 7];
+    epSquare = -1;
+    if(flags & MOVE_EN_PASSANT){
+        // en passant takes the pawn behind the square moved to
+        remove(to + (us == WHITE ? 8 : -8));
+    } else if(flags & MOVE_CAPTURE){
+        remove(to);
+    }
+    remove(from);
+    put(to, promotion ? (us | promotion) : piece);
+
+    if(flags & MOVE_DOUBLE_PUSH){
+        epSquare = (from + to) / 2;
+        key ^= zobristEnPassant[epSquare & 7];
+    } else if(flags & MOVE_CASTLING){
+        // castling: the rook jumps over the king
+        int rookFrom = (to > from) ? from + 3 : from - 4;
+        int rookTo = (to > from) ? from + 1 : from - 1;
+        put(rookTo, squares[rookFrom]);
+        remove(rookFrom);
+    }
+
+    int kept = castling & castlingKept(from) & castlingKept(to);
+    key ^= zobristCastling[castling] ^ zobristCastling[kept];
+    castling = kept;
+    side = us ^ BLACK;
+    key ^= zobristSide;
+    return !inCheck(us);
+}
+
+string moveToString(Move move){
+    string res;
+    for(int sq: {MOVE_FROM(move), MOVE_TO(move)}){
+        res += (char)('a' + sq % 8);
+        res += (char)('8' - sq / 8);
+    }
+    if(MOVE_PROMOTION(move)) res += " prnbqk"[MOVE_PROMOTION(move)];
+    return res;
+}
+
+void displayBoardValues(uint8_t * board){
+    for(int r = 0; r < 8; r++){
+        for(int c = 0; c < 8; c++){
+            cout << "[" << board[r*8+c] << "] ";
+        }
+        cout << endl;
+    }
+}
+
+void displayBoard(uint8_t * board){
+    for(int r = 0; r < 8; r++){
+        for(int c = 0; c < 8; c++){
+            int piece = board[r * 8 + c];
+            char pieceCh = ' ';
+
+            switch (piece)
+            {
+            case 1: pieceCh = 'P'; break;
+            case 2: pieceCh = 'R'; break;
+            case 3: pieceCh = 'N'; break;
+            case 4: pieceCh = 'B'; break;
+            case 5: pieceCh = 'Q'; break;
+            case 6: pieceCh = 'K'; break;
+            case 9: pieceCh = 'p'; break;
+            case 10: pieceCh = 'r'; break;
+            case 11: pieceCh = 'n'; break;
+            case 12: pieceCh = 'b'; break;
+            case 13: pieceCh = 'q'; break;
+            case 14: pieceCh = 'k'; break;
+            default: break;
+            }
+            cout << "[" << pieceCh << "] ";
+        }
+        cout << endl;
+    }
+}
+
+void displayBoard(const Board &board){
+    displayBoard((uint8_t *)board.squares);
+}
+
+int initBoard(const char* fen, uint8_t * board){
+    int i = 0; // index in the board array
+    while (*fen && *fen != ' ') {
+        if (isdigit(*fen)) {
+            i += *fen - '0';
+        } else if (*fen == '/') {
+            fen++; // Move to the next character after '/'
+            continue;
+        } else {
+            int piece = EMPTY;
+            switch(*fen) {
+                case 'P': piece = PAWN | WHITE; break;
+                case 'R': piece = ROOK | WHITE; break;
+                case 'N': piece = KNIGHT | WHITE; break;
+                case 'B': piece = BISHOP | WHITE; break;
+                case 'Q': piece = QUEEN | WHITE; break;
+                case 'K': piece = KING | WHITE; break;
+                case 'p': piece = PAWN | BLACK; break;
+                case 'r': piece = ROOK | BLACK; break;
+                case 'n': piece = KNIGHT | BLACK; break;
+                case 'b': piece = BISHOP | BLACK; break;
+                case 'q': piece = QUEEN | BLACK; break;
+                case 'k': piece = KING | BLACK; break;
+                default:
+                    cerr << "Invalid character in FEN string." << endl;
+                    return -1;
+            }
+            board[i++] = piece;
+        }
+        fen++;
+    }
+
+    return 0;
+}
+
+int initBoard(const char* fen, Board &board){
+    board.clear();
+    if(initBoard(fen, board.squares) < 0) return -1;
+    board.sync();
+    if(popCount(board.pieces[WHITE | KING]) != 1 || popCount(board.pieces[BLACK | KING]) != 1){
+        cerr << "FEN string needs one king of each color." << endl;
+        return -1;
+    }
+
+    // Fields after the placement
+    char sideField[8] = "w", castlingField[8] = "", epField[8] = "-";
+    const char *rest = strchr(fen, ' ');
+    int fields = rest ? sscanf(rest, "%7s %7s %7s", sideField, castlingField, epField) : 0;
+
+    board.side = (sideField[0] == 'b') ? BLACK : WHITE;
+    if(fields >= 2){
+        for(const char *c = castlingField; *c; c++){
+            if(*c == 'K') board.castling |= 1 << WHITE_KING_SIDE;
+            if(*c == 'Q') board.castling |= 1 << WHITE_QUEEN_SIDE;
+            if(*c == 'k') board.castling |= 1 << BLACK_KING_SIDE;
+            if(*c == 'q') board.castling |= 1 << BLACK_QUEEN_SIDE;
+        }
+    } else {
+        board.castling = ALL_CASTLING;
+    }
+    // no right without its king and rook at home
+    const int rooks[4] = {63, 56, 7, 0};
+    for(int s = WHITE_KING_SIDE; s <= BLACK_QUEEN_SIDE; s++){
+        int color = (s <= WHITE_QUEEN_SIDE) ? WHITE : BLACK;
+        int home = (color == WHITE) ? 60 : 4;
+        if(board.squares[home] != (color | KING) || board.squares[rooks[s]] != (color | ROOK)){
+            board.castling &= ~(1 << s);
+        }
+    }
+    if(fields >= 3 && epField[0] >= 'a' && epField[0] <= 'h' && epField[1] >= '1' && epField[1] <= '8'){
+        board.epSquare = ('8' - epField[1]) * 8 + (epField[0] - 'a');
+    }
+    board.key = board.computeKey();
+    return 0;
+}
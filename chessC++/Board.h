@@ -0,0 +1,125 @@
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include <stdint.h>
+#include <string>
+#include "Bitboard.h"
+#include "Move.h"
+
+using namespace std;
+
+// Pieces
+#define EMPTY 0
+#define PAWN 1
+#define ROOK 2
+#define KNIGHT 3
+#define BISHOP 4
+#define QUEEN 5
+#define KING 6
+#define PIECE 7
+#define BLACK 8
+#define WHITE 0
+
+// Castling constants
+#define WHITE_KING_SIDE 0
+#define WHITE_QUEEN_SIDE 1
+#define BLACK_KING_SIDE 2
+#define BLACK_QUEEN_SIDE 3
+#define WHITE_KING 0
+#define BLACK_KING 1
+
+// Castling rights of a Board: bit 1 << side for each of the four sides above
+#define ALL_CASTLING 15
+
+inline int getPiece(int n){
+    return (n & PIECE);
+}
+
+inline int getColor(int n){
+    return (n & BLACK);
+}
+
+// 0 for WHITE, 1 for BLACK
+inline int colorIndex(int color){
+    return color >> 3;
+}
+
+// Zobrist keys: the key of a position is the XOR of the keys of its pieces
+// on their squares, of its castling rights, of its en passant file and, if
+// black is to move, of zobristSide
+extern uint64_t zobristPieces[16][64];
+extern uint64_t zobristCastling[16];
+extern uint64_t zobristEnPassant[8];
+extern uint64_t zobristSide;
+
+// Fills the keys; call once before setting up any board
+void initZobrist();
+
+// Material plus piece-square value of each piece on each square, for the
+// midgame and the endgame, from white's view: black's values are negative.
+// Filled by initEval, before any board is set up.
+extern int pieceSquareMg[16][64];
+extern int pieceSquareEg[16][64];
+
+// A position as 12 piece bitboards plus occupancy, kept next to the same
+// position as a board[64] array. A Board is small enough to be copied: the
+// bitboard generator plays a move on a copy and throws the copy away.
+class Board {
+public:
+    Bitboard pieces[16];    // pieces[color | piece]: the squares of each of the 12 pieces
+    Bitboard colors[2];     // colors[colorIndex(color)]: all pieces of one side
+    Bitboard occupied;
+    uint8_t squares[64];    // the board[64] array of this position
+    int side;               // WHITE or BLACK to move
+    int castling;           // castling rights
+    int epSquare;           // square a pawn passed by moving 2 squares in the last move, or -1
+    uint64_t key;           // Zobrist key, kept up to date by put, remove and makeMove
+    int psqMg, psqEg;       // sums of pieceSquareMg and pieceSquareEg, kept up to date by put and remove
+
+    void clear();
+    void put(int sq, int piece);
+    void remove(int sq);
+    void sync();            // rebuilds the bitboards, the key and the sums from squares[]
+    uint64_t computeKey() const;
+
+    // All squares the pieces of color attack
+    Bitboard attacksBy(int color) const;
+
+    // Pieces of color attacking sq when the board holds the pieces of occupied
+    Bitboard attackersTo(int sq, int color, Bitboard occupied) const;
+    bool isSquareAttacked(int sq, int byColor) const { return attackersTo(sq, byColor, occupied) != 0; }
+    bool inCheck(int color) const { return isSquareAttacked(lsb(pieces[color | KING]), color ^ BLACK); }
+
+    // Pieces of color that are the only piece between their king and an enemy slider
+    Bitboard pinned(int color) const;
+
+    // Appends the pseudo-legal moves of the side to move
+    void generateMoves(MoveList &moves) const;
+
+    // Appends the legal moves of the side to move
+    void generateLegalMoves(MoveList &moves) const;
+
+    // The Move from one square to another in this position, its flags and
+    // captured piece read from the board
+    Move encodeMove(int from, int to, int promotion) const;
+
+    // Plays a pseudo-legal move; false if it leaves the mover's king attacked
+    bool makeMove(Move move);
+};
+
+// Piece placement of a FEN string into a board[64] array
+int initBoard(const char* fen, uint8_t * board);
+
+// A whole FEN string: placement, side to move, castling rights and en passant square.
+// Missing fields default to white to move, every castling whose king and rook
+// are still at home, and no en passant.
+int initBoard(const char* fen, Board &board);
+
+// A move in coordinate notation: "e2e4", "e7e8q"
+string moveToString(Move move);
+
+void displayBoard(uint8_t * board);
+void displayBoard(const Board &board);
+void displayBoardValues(uint8_t * board);
+
+#endif
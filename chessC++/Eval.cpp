@@ -0,0 +1,254 @@
+#include "Eval.h"
+
+// Indexed by piece: PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING
+static const int materialMg[8] = {0, 82, 477, 337, 365, 1025, 0, 0};
+static const int materialEg[8] = {0, 94, 512, 281, 297, 936, 0, 0};
+// Phases a piece is worth: 24 with all of them on the board, the midgame
+static const int phaseWeight[8] = {0, 0, 2, 1, 1, 4, 0, 0};
+#define MAX_PHASE 24
+
+// Piece-square tables from white's view, a8 first as in squares[]; black
+// reads them upside down
+static const int pawnMg[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+     50, 50, 50, 50, 50, 50, 50, 50,
+     10, 10, 20, 30, 30, 20, 10, 10,
+      5,  5, 10, 25, 25, 10,  5,  5,
+      0,  0,  0, 20, 20,  0,  0,  0,
+      5, -5,-10,  0,  0,-10, -5,  5,
+      5, 10, 10,-20,-20, 10, 10,  5,
+      0,  0,  0,  0,  0,  0,  0,  0,
+};
+static const int pawnEg[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+     80, 80, 80, 80, 80, 80, 80, 80,
+     50, 50, 50, 50, 50, 50, 50, 50,
+     30, 30, 30, 30, 30, 30, 30, 30,
+     15, 15, 15, 15, 15, 15, 15, 15,
+      5,  5,  5,  5,  5,  5,  5,  5,
+      0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,
+};
+static const int rookTable[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0,
+};
+static const int knightTable[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+};
+static const int bishopTable[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+};
+static const int queenTable[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20,
+};
+static const int kingMg[64] = {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20,
+};
+static const int kingEg[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50,
+};
+static const int *tablesMg[8] = {NULL, pawnMg, rookTable, knightTable, bishopTable, queenTable, kingMg, NULL};
+static const int *tablesEg[8] = {NULL, pawnEg, rookTable, knightTable, bishopTable, queenTable, kingEg, NULL};
+
+// Mobility: per square a piece attacks, not held by its side nor by an
+// enemy pawn, beyond the usual number
+static const int mobilityUsual[8] = {0, 0, 7, 4, 7, 14, 0, 0};
+static const int mobilityMg[8] = {0, 0, 2, 4, 5, 1, 0, 0};
+static const int mobilityEg[8] = {0, 0, 4, 4, 5, 2, 0, 0};
+
+// Pawn structure; passed pawns by rank from their own side
+#define DOUBLED_MG 10
+#define DOUBLED_EG 20
+#define ISOLATED_MG 10
+#define ISOLATED_EG 15
+static const int passedMg[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+static const int passedEg[8] = {0, 10, 20, 35, 60, 90, 130, 0};
+
+// King safety: attacks on the squares around a king weigh by attacker, and
+// count more the more pieces take part (percent, by number of attackers);
+// pawns in front of a king shield it in the midgame
+static const int attackWeight[8] = {0, 0, 3, 2, 2, 5, 0, 0};
+static const int attackShare[8] = {0, 0, 50, 75, 88, 94, 97, 99};
+#define SHIELD_MG 10
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_H 0x8080808080808080ULL
+
+static Bitboard fileMasks[8];
+static Bitboard adjacentFiles[8];
+static Bitboard passedMasks[2][64];     // [side][sq]: squares ahead of a pawn, on its file and the next ones
+static Bitboard shieldMasks[2][64];     // [side][sq]: the 2 ranks ahead of a king, on its file and the next ones
+
+// All of row r, 0 (rank 8) to 7 (rank 1); nothing off the board
+static Bitboard rowMask(int r){
+    return (r >= 0 && r < 8) ? 0xFFULL << (8 * r) : 0;
+}
+
+void initEval(){
+    for(int piece = PAWN; piece <= KING; piece++){
+        for(int sq = 0; sq < 64; sq++){
+            pieceSquareMg[WHITE | piece][sq] = materialMg[piece] + tablesMg[piece][sq];
+            pieceSquareEg[WHITE | piece][sq] = materialEg[piece] + tablesEg[piece][sq];
+            pieceSquareMg[BLACK | piece][sq] = -(materialMg[piece] + tablesMg[piece][sq ^ 56]);
+            pieceSquareEg[BLACK | piece][sq] = -(materialEg[piece] + tablesEg[piece][sq ^ 56]);
+        }
+    }
+
+    for(int f = 0; f < 8; f++) fileMasks[f] = FILE_A << f;
+    for(int f = 0; f < 8; f++){
+        adjacentFiles[f] = (f > 0 ? fileMasks[f - 1] : 0) | (f < 7 ? fileMasks[f + 1] : 0);
+    }
+    for(int sq = 0; sq < 64; sq++){
+        int r = sq >> 3, f = sq & 7;
+        Bitboard span = fileMasks[f] | adjacentFiles[f];
+        Bitboard above = 0, below = 0;
+        for(int row = 0; row < r; row++) above |= rowMask(row);
+        for(int row = r + 1; row < 8; row++) below |= rowMask(row);
+        // white moves up the rows, black down
+        passedMasks[0][sq] = span & above;
+        passedMasks[1][sq] = span & below;
+        shieldMasks[0][sq] = span & (rowMask(r - 1) | rowMask(r - 2));
+        shieldMasks[1][sq] = span & (rowMask(r + 1) | rowMask(r + 2));
+    }
+}
+
+// The pawn terms of a position, from white's view; they depend on nothing
+// but the pawns, which few moves change
+struct PawnEntry {
+    Bitboard white, black;
+    int mg, eg;
+};
+
+// Per thread, so the threads of a search need no lock; a zeroed entry is
+// right for a position with no pawns
+#define PAWN_CACHE_SIZE 16384
+static thread_local PawnEntry pawnCache[PAWN_CACHE_SIZE];
+
+static void evaluatePawns(Bitboard whitePawns, Bitboard blackPawns, int &mg, int &eg){
+    mg = eg = 0;
+    for(int c = 0; c < 2; c++){
+        Bitboard own = c ? blackPawns : whitePawns;
+        Bitboard other = c ? whitePawns : blackPawns;
+        int sign = c ? -1 : 1;
+        for(int f = 0; f < 8; f++){
+            int n = popCount(own & fileMasks[f]);
+            if(n > 1){
+                mg -= sign * DOUBLED_MG * (n - 1);
+                eg -= sign * DOUBLED_EG * (n - 1);
+            }
+            if(n && !(own & adjacentFiles[f])){
+                mg -= sign * ISOLATED_MG * n;
+                eg -= sign * ISOLATED_EG * n;
+            }
+        }
+        Bitboard pawns = own;
+        while(pawns){
+            int sq = popLsb(pawns);
+            if(passedMasks[c][sq] & other) continue;
+            int rank = c ? (sq >> 3) : 7 - (sq >> 3);
+            mg += sign * passedMg[rank];
+            eg += sign * passedEg[rank];
+        }
+    }
+}
+
+int evaluate(const Board &board){
+    int mg = board.psqMg, eg = board.psqEg;
+
+    int phase = 0;
+    for(int piece = ROOK; piece <= QUEEN; piece++){
+        phase += phaseWeight[piece] * popCount(board.pieces[WHITE | piece] | board.pieces[BLACK | piece]);
+    }
+    if(phase > MAX_PHASE) phase = MAX_PHASE;
+
+    Bitboard whitePawns = board.pieces[WHITE | PAWN], blackPawns = board.pieces[BLACK | PAWN];
+    PawnEntry &entry = pawnCache[(whitePawns * 0x9E3779B97F4A7C15ULL ^ blackPawns * 0xC2B2AE3D27D4EB4FULL) >> 50];
+    if(entry.white != whitePawns || entry.black != blackPawns){
+        entry.white = whitePawns;
+        entry.black = blackPawns;
+        evaluatePawns(whitePawns, blackPawns, entry.mg, entry.eg);
+    }
+    mg += entry.mg;
+    eg += entry.eg;
+
+    // white pawns move up the rows, to lower squares
+    Bitboard pawnAttacked[2] = {
+        ((whitePawns & ~FILE_A) >> 9) | ((whitePawns & ~FILE_H) >> 7),
+        ((blackPawns & ~FILE_A) << 7) | ((blackPawns & ~FILE_H) << 9),
+    };
+    for(int c = 0; c < 2; c++){
+        int color = c ? BLACK : WHITE;
+        int sign = c ? -1 : 1;
+        Bitboard safe = ~board.colors[c] & ~pawnAttacked[c ^ 1];
+        Bitboard enemyKing = board.pieces[(color ^ BLACK) | KING];
+        Bitboard zone = enemyKing ? kingAttacks[lsb(enemyKing)] | enemyKing : 0;
+        int attackers = 0, weight = 0;
+
+        for(int piece = ROOK; piece <= QUEEN; piece++){
+            Bitboard bb = board.pieces[color | piece];
+            while(bb){
+                int sq = popLsb(bb);
+                Bitboard attacks = (piece == KNIGHT) ? knightAttacks[sq]
+                                 : (piece == BISHOP) ? bishopAttacks(sq, board.occupied)
+                                 : (piece == ROOK) ? rookAttacks(sq, board.occupied)
+                                 : queenAttacks(sq, board.occupied);
+                int n = popCount(attacks & safe) - mobilityUsual[piece];
+                mg += sign * mobilityMg[piece] * n;
+                eg += sign * mobilityEg[piece] * n;
+                if(attacks & zone){
+                    attackers++;
+                    weight += attackWeight[piece] * popCount(attacks & zone);
+                }
+            }
+        }
+        mg += sign * weight * attackShare[attackers < 7 ? attackers : 7] / 25;
+
+        Bitboard king = board.pieces[color | KING];
+        if(king) mg += sign * SHIELD_MG * popCount(board.pieces[color | PAWN] & shieldMasks[c][lsb(king)]);
+    }
+
+    int score = (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE;
+    return (board.side == WHITE) ? score : -score;
+}
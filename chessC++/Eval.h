@@ -0,0 +1,18 @@
+#ifndef _EVAL_H_
+#define _EVAL_H_
+
+#include "Board.h"
+
+// Tapered evaluation: every term has a midgame and an endgame value, mixed
+// by the material left on the board (24 phases, from all pieces but pawns
+// and kings down to none). The terms are material plus piece-square values,
+// kept by Board as pieces are put and removed; mobility; pawn structure,
+// cached by the pawns of both sides; and king safety.
+
+// Fills the piece-square tables of Board; call once before setting up any board
+void initEval();
+
+// Score of board from the side to move's view, in centipawns
+int evaluate(const Board &board);
+
+#endif
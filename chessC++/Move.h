@@ -0,0 +1,53 @@
+#ifndef _MOVE_H_
+#define _MOVE_H_
+
+#include <stdint.h>
+
+// A move packed in 32 bits, holding all that is needed to play it and to
+// take it back:
+//   bits  0-5   from square
+//   bits  6-11  to square
+//   bits 12-14  piece a pawn promotes to, 0 if none
+//   bits 15-18  flags below
+//   bits 19-22  piece captured (color | piece), EMPTY if none
+typedef uint32_t Move;
+
+#define MOVE_CAPTURE 1          // en passant included
+#define MOVE_EN_PASSANT 2
+#define MOVE_CASTLING 4
+#define MOVE_DOUBLE_PUSH 8      // a pawn moving 2 squares
+
+#define MOVE(from, to, promotion, flags, captured) \
+    ((Move)((from) | (to) << 6 | (promotion) << 12 | (flags) << 15 | (captured) << 19))
+#define MOVE_FROM(move) ((move) & 63)
+#define MOVE_TO(move) (((move) >> 6) & 63)
+#define MOVE_PROMOTION(move) (((move) >> 12) & 7)
+#define MOVE_FLAGS(move) (((move) >> 15) & 15)
+#define MOVE_CAPTURED(move) (((move) >> 19) & 15)
+
+// A position has at most 218 legal moves; 256 leaves room for the pseudo-legal ones
+#define MAX_MOVES 256
+
+// The moves of one generation, kept on the stack of its caller
+class MoveList {
+public:
+    MoveList() : count(0) { }
+
+    void add(Move move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    void resize(int n) { count = n; }
+
+    Move &operator[](int i) { return moves[i]; }
+    Move operator[](int i) const { return moves[i]; }
+    Move *begin() { return moves; }
+    Move *end() { return moves + count; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
+
+private:
+    Move moves[MAX_MOVES];
+    int count;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <omp.h>
+#include "Perft.h"
+
+using namespace std;
+
+#if COUNT_ALLOCATIONS
+// Every new of the program, counted on its way to malloc
+static atomic<long long> allocations(0);
+
+void *operator new(size_t size){
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if(!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+long long allocationCount(){ return allocations; }
+#else
+long long allocationCount(){ return 0; }
+#endif
+
+// https://www.chessprogramming.org/Perft_Results
+const PerftCase perftSuite[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+     {1, 20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     {1, 48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+     {1, 14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+     {1, 6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     {1, 44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+     {1, 46, 2079, 89890, 3894594, 164075551, 0}},
+};
+const int perftSuiteSize = sizeof(perftSuite) / sizeof(perftSuite[0]);
+
+unsigned long long perft(Position &position, int depth){
+    if(depth == 0) return 1;
+
+    MoveList moves;
+    position.generateLegalMoves(moves);
+    // bulk counting: every legal move at the last ply is one leaf
+    if(depth == 1) return moves.size();
+
+    unsigned long long nodes = 0;
+    for(Move move: moves){
+        position.makeMove(move);
+        nodes += perft(position, depth - 1);
+        position.unmakeMove();
+    }
+    return nodes;
+}
+
+// Entries hold the count alone: a count stored for another depth is a miss
+unsigned long long perftHashed(Position &position, int depth, TranspositionTable &table, TableStats &stats){
+    if(depth == 0) return 1;
+
+    MoveList moves;
+    if(depth == 1){
+        position.generateLegalMoves(moves);
+        return moves.size();
+    }
+
+    uint64_t payload;
+    int storedDepth;
+    stats.probes++;
+    if(table.probe(position.key, payload, storedDepth) && storedDepth == depth){
+        stats.hits++;
+        return payload;
+    }
+
+    position.generateLegalMoves(moves);
+    unsigned long long nodes = 0;
+    for(Move move: moves){
+        position.makeMove(move);
+        nodes += perftHashed(position, depth - 1, table, stats);
+        position.unmakeMove();
+    }
+    table.store(position.key, nodes, depth);
+    return nodes;
+}
+
+// Leaves under each legal root move, the moves taken by threads as they free up
+static vector<unsigned long long> perftRoot(const Position &position, int depth, int threads, MoveList &moves,
+                                            TranspositionTable *table, TableStats *stats){
+    position.generateLegalMoves(moves);
+    vector<unsigned long long> counts(moves.size(), 0);
+
+    // every thread plays its moves on a copy of its own and counts its own lookups
+    #pragma omp parallel num_threads(threads)
+    {
+        Position local = position;
+        TableStats localStats = {0, 0};
+        #pragma omp for schedule(dynamic)
+        for(int i = 0; i < moves.size(); i++){
+            local.makeMove(moves[i]);
+            counts[i] = table ? perftHashed(local, depth - 1, *table, localStats) : perft(local, depth - 1);
+            local.unmakeMove();
+        }
+        if(stats){
+            #pragma omp critical
+            {
+                stats->probes += localStats.probes;
+                stats->hits += localStats.hits;
+            }
+        }
+    }
+    return counts;
+}
+
+unsigned long long perftParallel(const Position &position, int depth, int threads,
+                                 TranspositionTable *table, TableStats *stats){
+    if(depth == 0) return 1;
+
+    MoveList moves;
+    unsigned long long nodes = 0;
+    for(unsigned long long count: perftRoot(position, depth, threads, moves, table, stats)) nodes += count;
+    return nodes;
+}
+
+unsigned long long divide(const Position &position, int depth, int threads,
+                          TranspositionTable *table, TableStats *stats){
+    if(depth <= 0) return 1;
+
+    MoveList moves;
+    vector<unsigned long long> counts = perftRoot(position, depth, threads, moves, table, stats);
+    unsigned long long nodes = 0;
+    for(int i = 0; i < moves.size(); i++){
+        cout << moveToString(moves[i]) << ": " << counts[i] << endl;
+        nodes += counts[i];
+    }
+    cout << endl << "moves: " << moves.size() << endl;
+    cout << "nodes: " << nodes << endl;
+    return nodes;
+}
+
+int runPerftSuite(int maxDepth, int threads){
+    int failures = 0;
+    unsigned long long totalNodes = 0;
+    double totalTime = 0;
+
+    cout << "position\tdepth\tnodes\texpected\ttime (s)\tnps\tallocs/node" << endl;
+    for(int i = 0; i < perftSuiteSize; i++){
+        const PerftCase &test = perftSuite[i];
+        int depth = test.depth;
+        if(maxDepth > 0) depth = min(maxDepth, PERFT_MAX_DEPTH);
+        while(depth > 0 && test.nodes[depth] == 0) depth--;
+
+        Position position;
+        if(initBoard(test.fen, position) < 0){
+            failures++;
+            continue;
+        }
+        long long allocated = allocationCount();
+        auto start = chrono::steady_clock::now();
+        unsigned long long nodes = perftParallel(position, depth, threads);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        totalNodes += nodes;
+        totalTime += seconds;
+
+        bool ok = (nodes == test.nodes[depth]);
+        if(!ok) failures++;
+        cout << test.name << "\t" << depth << "\t" << nodes << "\t" << test.nodes[depth] << "\t"
+             << seconds << "\t" << (long long)(nodes / max(seconds, 1e-9)) << "\t"
+             << (double)(allocationCount() - allocated) / nodes << (ok ? "" : "\tWRONG") << endl;
+    }
+    cout << "total\t\t" << totalNodes << "\t\t" << totalTime << "\t"
+         << (long long)(totalNodes / max(totalTime, 1e-9)) << endl;
+    return failures;
+}
@@ -0,0 +1,54 @@
+#ifndef _PERFT_H_
+#define _PERFT_H_
+
+#include "Position.h"
+#include "TT.h"
+
+// Perft: the number of leaves of the legal move tree of a position at a
+// depth. Counts of standard positions are published, so perft is the
+// reference for every change to the move generator.
+
+// Number of leaves of position at depth, by make/unmake on position. The
+// last ply is counted without being recursed into (bulk counting).
+unsigned long long perft(Position &position, int depth);
+
+// The same, looking every subtree of depth 2 or more up in table before
+// walking it, and storing its count after; stats counts the lookups
+unsigned long long perftHashed(Position &position, int depth, TranspositionTable &table, TableStats &stats);
+
+// perft or, given a table, perftHashed, with the root moves split among
+// threads; the threads share the table
+unsigned long long perftParallel(const Position &position, int depth, int threads,
+                                 TranspositionTable *table = NULL, TableStats *stats = NULL);
+
+// Prints the leaves under each root move, then the total
+unsigned long long divide(const Position &position, int depth, int threads,
+                          TranspositionTable *table = NULL, TableStats *stats = NULL);
+
+// Build with -DCOUNT_ALLOCATIONS=0 to leave the global operator new alone
+#ifndef COUNT_ALLOCATIONS
+#define COUNT_ALLOCATIONS 1
+#endif
+
+// Heap allocations made so far by the whole program, 0 if not counted
+long long allocationCount();
+
+// A position of the suite with its published counts (0 where not listed)
+#define PERFT_MAX_DEPTH 6
+
+struct PerftCase {
+    const char *name;
+    const char *fen;
+    int depth;                                  // depth the suite runs by default
+    unsigned long long nodes[PERFT_MAX_DEPTH + 1];
+};
+
+extern const PerftCase perftSuite[];
+extern const int perftSuiteSize;
+
+// Runs every position of the suite to its default depth, or to maxDepth if
+// given (> 0) and listed; prints nodes, time and nps, and returns the number
+// of positions whose count is wrong
+int runPerftSuite(int maxDepth, int threads);
+
+#endif
@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include "Position.h"
+
+bool Position::makeMove(Move move){
+    Undo undo = {move, castling, epSquare, key};
+    history.push_back(undo);
+    return Board::makeMove(move);
+}
+
+void Position::unmakeMove(){
+    Undo undo = history.back();
+    history.pop_back();
+
+    Move move = undo.move;
+    int from = MOVE_FROM(move), to = MOVE_TO(move), flags = MOVE_FLAGS(move);
+    int us = side ^ BLACK;
+    int piece = MOVE_PROMOTION(move) ? (us | PAWN) : squares[to];
+
+    side = us;
+    castling = undo.castling;
+    epSquare = undo.epSquare;
+
+    remove(to);
+    put(from, piece);
+    if(flags & MOVE_EN_PASSANT){
+        put(to + (us == WHITE ? 8 : -8), MOVE_CAPTURED(move));
+    } else if(flags & MOVE_CAPTURE){
+        put(to, MOVE_CAPTURED(move));
+    } else if(flags & MOVE_CASTLING){
+        // the rook goes back to its corner
+        int rookFrom = (to > from) ? from + 3 : from - 4;
+        int rookTo = (to > from) ? from + 1 : from - 1;
+        put(rookFrom, squares[rookTo]);
+        remove(rookTo);
+    }
+    key = undo.key;
+}
+
+vector<int> Position::capturedPieces() const {
+    vector<int> res;
+    for(const Undo &undo: history){
+        if(MOVE_CAPTURED(undo.move)) res.push_back(MOVE_CAPTURED(undo.move));
+    }
+    return res;
+}
+
+int initBoard(const char* fen, Position &position){
+    position.history.clear();
+    return initBoard(fen, (Board &)position);
+}
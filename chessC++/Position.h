@@ -0,0 +1,43 @@
+#ifndef _POSITION_H_
+#define _POSITION_H_
+
+#include <vector>
+#include "Board.h"
+
+using namespace std;
+
+// What makeMove changed and unmakeMove puts back; the piece captured is in the move
+struct Undo {
+    Move move;
+    int castling;           // rights before the move
+    int epSquare;           // en passant square before the move
+    uint64_t key;           // Zobrist key before the move
+};
+
+// Plies the undo stack holds before it has to grow
+#define MAX_PLY 1024
+
+// The whole state of a game: the Board plus the moves played on it. A
+// Position owns everything a search or the board[64] generator reads, so
+// every thread can work on a Position of its own.
+class Position : public Board {
+public:
+    Position() { clear(); history.reserve(MAX_PLY); }
+
+    // Plays a pseudo-legal move and pushes its undo record. Returns false if
+    // it leaves the mover's king attacked; the move is played either way.
+    bool makeMove(Move move);
+
+    // Takes back the last move played
+    void unmakeMove();
+
+    // Pieces taken so far, in the order they were taken
+    vector<int> capturedPieces() const;
+
+    vector<Undo> history;   // the undo stack, last move on top
+};
+
+// A whole FEN string, as initBoard(fen, Board&), with no move played yet
+int initBoard(const char* fen, Position &position);
+
+#endif
@@ -0,0 +1,321 @@
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "Search.h"
+
+using namespace std;
+
+// Victims and promotions by value, indexed by piece: PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING
+static const int pieceValues[8] = {0, 100, 500, 320, 330, 900, 0, 0};
+// Least valuable attacker first among captures of the same victim
+static const int attackerOrder[8] = {0, 1, 4, 2, 3, 5, 6, 0};
+
+// Move ordering: bands kept apart so that no history count reaches a killer
+#define ORDER_PV (1 << 30)
+#define ORDER_CAPTURE (1 << 24)
+#define ORDER_KILLER (1 << 22)
+
+// What a table entry's score is to the true one
+#define BOUND_EXACT 0
+#define BOUND_LOWER 1
+#define BOUND_UPPER 2
+
+// Payload of a table entry: move in bits 0-22, score + 32768 in 23-38, bound in 39-40
+#define ENTRY(move, score, bound) ((uint64_t)(move) | (uint64_t)((score) + 32768) << 23 | (uint64_t)(bound) << 39)
+#define ENTRY_MOVE(entry) ((Move)((entry) & 0x7FFFFF))
+#define ENTRY_SCORE(entry) ((int)(((entry) >> 23) & 0xFFFF) - 32768)
+#define ENTRY_BOUND(entry) ((int)(((entry) >> 39) & 3))
+
+// Mate scores count plies from the root; in the table they count from the
+// node, so that they hold wherever the node is reached again
+static int scoreToTable(int score, int ply){
+    if(score >= MATE_SCORE - MAX_SEARCH_PLY) return score + ply;
+    if(score <= -MATE_SCORE + MAX_SEARCH_PLY) return score - ply;
+    return score;
+}
+
+static int scoreFromTable(int score, int ply){
+    if(score >= MATE_SCORE - MAX_SEARCH_PLY) return score - ply;
+    if(score <= -MATE_SCORE + MAX_SEARCH_PLY) return score + ply;
+    return score;
+}
+
+// Helper i of SmpSearch (1-based, cycling every 20) skips depth d when
+// (d + skipPhase) / skipSize is odd: helper 1 searches the even depths,
+// helper 2 the odd ones, helpers 3-6 two depths in four at four offsets, and
+// so on, so that every depth has some of the helpers on it at any time
+#define SKIP_HELPERS 20
+static const int skipSize[SKIP_HELPERS] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static const int skipPhase[SKIP_HELPERS] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+long long Search::elapsed() const {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+}
+
+// Looks at the clock and the stop signal every 1024 nodes
+bool Search::checkStop(){
+    if(limits.nodes && nodes >= limits.nodes) stopped = true;
+    if((nodes & 1023) == 0){
+        if(limits.movetime && elapsed() >= limits.movetime) stopped = true;
+        if(stopSignal && stopSignal->load(memory_order_relaxed)) stopped = true;
+    }
+    return stopped;
+}
+
+void Search::scoreMoves(const Position &position, const MoveList &moves, int scores[], int ply, Move hashMove) const {
+    int us = colorIndex(position.side);
+    for(int i = 0; i < moves.size(); i++){
+        Move move = moves[i];
+        int from = MOVE_FROM(move), to = MOVE_TO(move);
+        if((ply < pvLength && move == pv[ply]) || move == hashMove){
+            scores[i] = ORDER_PV;
+        } else if(MOVE_FLAGS(move) & MOVE_CAPTURE){
+            scores[i] = ORDER_CAPTURE + pieceValues[getPiece(MOVE_CAPTURED(move))] * 8
+                      - attackerOrder[getPiece(position.squares[from])] + pieceValues[MOVE_PROMOTION(move)];
+        } else if(MOVE_PROMOTION(move)){
+            scores[i] = ORDER_CAPTURE + pieceValues[MOVE_PROMOTION(move)];
+        } else if(move == killers[ply][0]){
+            scores[i] = ORDER_KILLER + 1;
+        } else if(move == killers[ply][1]){
+            scores[i] = ORDER_KILLER;
+        } else {
+            scores[i] = history[us][from][to];
+        }
+    }
+}
+
+// Brings the best scored move of i.. to i
+static void pickMove(MoveList &moves, int scores[], int i){
+    int best = i;
+    for(int j = i + 1; j < moves.size(); j++){
+        if(scores[j] > scores[best]) best = j;
+    }
+    Move move = moves[i];
+    moves[i] = moves[best];
+    moves[best] = move;
+    int score = scores[i];
+    scores[i] = scores[best];
+    scores[best] = score;
+}
+
+int Search::quiescence(Position &position, int ply, int alpha, int beta){
+    pvTableLength[ply] = ply;
+    nodes++;
+    if(checkStop()) return 0;
+
+    if(ply >= MAX_SEARCH_PLY - 1) return evaluate(position);
+
+    // in check there is no standing pat: every evasion is searched, and
+    // none is mate
+    bool inCheck = position.inCheck(position.side);
+    if(!inCheck){
+        int standPat = evaluate(position);
+        if(standPat >= beta) return standPat;
+        if(standPat > alpha) alpha = standPat;
+    }
+
+    MoveList moves;
+    position.generateLegalMoves(moves);
+    if(inCheck){
+        if(moves.size() == 0) return -MATE_SCORE + ply;
+    } else {
+        // captures and promotions only
+        int kept = 0;
+        for(int i = 0; i < moves.size(); i++){
+            if((MOVE_FLAGS(moves[i]) & MOVE_CAPTURE) || MOVE_PROMOTION(moves[i])) moves[kept++] = moves[i];
+        }
+        moves.resize(kept);
+    }
+
+    int scores[MAX_MOVES];
+    scoreMoves(position, moves, scores, ply, 0);
+    for(int i = 0; i < moves.size(); i++){
+        pickMove(moves, scores, i);
+        position.makeMove(moves[i]);
+        int score = -quiescence(position, ply + 1, -beta, -alpha);
+        position.unmakeMove();
+        if(stopped) return 0;
+        if(score > alpha){
+            if(score >= beta) return score;
+            alpha = score;
+        }
+    }
+    return alpha;
+}
+
+int Search::alphaBeta(Position &position, int depth, int ply, int alpha, int beta){
+    if(depth <= 0) return quiescence(position, ply, alpha, beta);
+
+    pvTableLength[ply] = ply;
+    nodes++;
+    if(checkStop()) return 0;
+    if(ply >= MAX_SEARCH_PLY - 1) return evaluate(position);
+
+    bool inCheck = position.inCheck(position.side);
+    if(inCheck) depth++;    // look one ply further out of checks
+
+    // a bound good enough for this depth ends the node; the root always
+    // searches, so that it has a principal variation
+    Move hashMove = 0;
+    if(table){
+        uint64_t entry;
+        int entryDepth;
+        tableStats.probes++;
+        if(table->probe(position.key, entry, entryDepth)){
+            tableStats.hits++;
+            hashMove = ENTRY_MOVE(entry);
+            int entryScore = scoreFromTable(ENTRY_SCORE(entry), ply);
+            int bound = ENTRY_BOUND(entry);
+            if(ply > 0 && entryDepth >= depth && (bound == BOUND_EXACT || (bound == BOUND_LOWER && entryScore >= beta)
+                                                  || (bound == BOUND_UPPER && entryScore <= alpha))){
+                return entryScore;
+            }
+        }
+    }
+
+    MoveList moves;
+    position.generateLegalMoves(moves);
+    if(moves.size() == 0) return inCheck ? -MATE_SCORE + ply : 0;
+
+    int scores[MAX_MOVES];
+    scoreMoves(position, moves, scores, ply, hashMove);
+    int alphaStart = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = 0;
+    for(int i = 0; i < moves.size(); i++){
+        pickMove(moves, scores, i);
+        Move move = moves[i];
+        position.makeMove(move);
+        int score = -alphaBeta(position, depth - 1, ply + 1, -beta, -alpha);
+        position.unmakeMove();
+        if(stopped) return 0;
+
+        if(score > bestScore){
+            bestScore = score;
+            bestMove = move;
+        }
+        if(score <= alpha) continue;
+        alpha = score;
+        pvTable[ply][ply] = move;
+        for(int next = ply + 1; next < pvTableLength[ply + 1]; next++) pvTable[ply][next] = pvTable[ply + 1][next];
+        pvTableLength[ply] = pvTableLength[ply + 1];
+
+        if(alpha >= beta){
+            if(!(MOVE_FLAGS(move) & MOVE_CAPTURE) && !MOVE_PROMOTION(move)){
+                if(move != killers[ply][0]){
+                    killers[ply][1] = killers[ply][0];
+                    killers[ply][0] = move;
+                }
+                history[colorIndex(position.side)][MOVE_FROM(move)][MOVE_TO(move)] += depth * depth;
+            }
+            break;
+        }
+    }
+
+    if(table){
+        int bound = (bestScore >= beta) ? BOUND_LOWER : (bestScore > alphaStart) ? BOUND_EXACT : BOUND_UPPER;
+        table->store(position.key, ENTRY(bestMove, scoreToTable(bestScore, ply), bound), depth);
+    }
+    return bestScore;
+}
+
+Move Search::go(Position &position, const SearchLimits &searchLimits, bool verbose){
+    limits = searchLimits;
+    start = chrono::steady_clock::now();
+    stopped = false;
+    nodes = 0;
+    depth = 0;
+    score = 0;
+    pvLength = 0;
+    tableStats.probes = tableStats.hits = 0;
+    if(table) table->newSearch();
+    memset(killers, 0, sizeof(killers));
+    memset(history, 0, sizeof(history));
+
+    int maxDepth = (limits.depth > 0 && limits.depth < MAX_SEARCH_PLY) ? limits.depth : MAX_SEARCH_PLY - 1;
+    for(int d = 1; d <= maxDepth; d++){
+        // helpers skip depths by their id but all search the last one
+        if(id > 0 && d < maxDepth){
+            int i = (id - 1) % SKIP_HELPERS;
+            if((d + skipPhase[i]) / skipSize[i] % 2) continue;
+        }
+        int s = alphaBeta(position, d, 0, -INFINITE_SCORE, INFINITE_SCORE);
+        // an unfinished depth is thrown away. Stopped before any depth was
+        // done, the move is the best root move searched to the end, if any,
+        // else the first legal one; depth stays 0 and nothing is reported.
+        if(stopped){
+            if(depth == 0 && pvTableLength[0] > 0){
+                pv[0] = pvTable[0][0];
+                pvLength = 1;
+            } else if(depth == 0){
+                MoveList moves;
+                position.generateLegalMoves(moves);
+                if(moves.size() > 0){
+                    pv[0] = moves[0];
+                    pvLength = 1;
+                }
+            }
+            break;
+        }
+
+        depth = d;
+        score = s;
+        pvLength = pvTableLength[0];
+        memcpy(pv, pvTable[0], pvLength * sizeof(Move));
+
+        if(verbose){
+            long long ms = elapsed();
+            cout << "info depth " << depth << " score ";
+            if(abs(score) >= MATE_SCORE - MAX_SEARCH_PLY){
+                int plies = MATE_SCORE - abs(score);
+                cout << "mate " << (score > 0 ? (plies + 1) / 2 : -(plies / 2));
+            } else {
+                cout << "cp " << score;
+            }
+            cout << " nodes " << nodes << " nps " << (long long)(nodes * 1000.0 / max(ms, 1LL))
+                 << " time " << ms << " pv";
+            for(int i = 0; i < pvLength; i++) cout << " " << moveToString(pv[i]);
+            cout << endl;
+        }
+        if(pvLength == 0) break;
+        if(stopSignal && stopSignal->load(memory_order_relaxed)) break;
+        // a mate found at this depth will not be shortened by a deeper one
+        if(abs(score) >= MATE_SCORE - d) break;
+        // a deeper iteration would not finish in the time left
+        if(limits.movetime && elapsed() * 2 >= limits.movetime) break;
+    }
+    return pvLength ? pv[0] : 0;
+}
+
+SmpSearch::SmpSearch(int threads, TranspositionTable *table) : stopSignal(false) {
+    searches.reserve(max(threads, 1));
+    for(int i = 0; i < max(threads, 1); i++) searches.push_back(Search(table, &stopSignal, i));
+}
+
+Move SmpSearch::go(Position &position, const SearchLimits &limits, bool verbose){
+    stopSignal = false;
+    if(searches.size() == 1) return searches[0].go(position, limits, verbose);
+
+    // helpers run to the depth limit or until stopped
+    SearchLimits helperLimits = {limits.depth, 0, 0};
+    Move best = 0;
+    #pragma omp parallel num_threads(searches.size())
+    {
+        int i = omp_get_thread_num();
+        Position local = position;
+        if(i == 0){
+            best = searches[0].go(local, limits, verbose);
+            stopSignal = true;
+        } else {
+            searches[i].go(local, helperLimits, false);
+        }
+    }
+    return best;
+}
+
+unsigned long long SmpSearch::nodes() const {
+    unsigned long long res = 0;
+    for(const Search &search: searches) res += search.nodes;
+    return res;
+}
@@ -0,0 +1,94 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include "Position.h"
+#include "TT.h"
+#include "Eval.h"
+
+using namespace std;
+
+#define MAX_SEARCH_PLY 128
+#define MATE_SCORE 30000            // mated at the root; mated n plies on scores -MATE_SCORE + n
+#define INFINITE_SCORE 32000
+
+// What ends a search: the first limit reached, 0 for none
+struct SearchLimits {
+    int depth;
+    int movetime;                   // milliseconds
+    unsigned long long nodes;
+};
+
+// Negamax alpha-beta by iterative deepening, with a quiescence search of
+// captures at the leaves. Moves are tried in the order: last iteration's
+// principal variation or the table's move, captures by MVV-LVA, killers,
+// history. Nothing depends on time but where a movetime limit stops the
+// search, so a depth- or node-limited search gives the same nodes and move
+// every run, given a table as it was.
+class Search {
+public:
+    // Bounds and best moves of searched nodes go to table, if given, and
+    // cut off or order the nodes reached again. A search also stops when
+    // stopSignal, if given, is set; id tells a helper thread (> 0) of
+    // SmpSearch from the main one.
+    explicit Search(TranspositionTable *table = NULL, atomic<bool> *stopSignal = NULL, int id = 0)
+        : table(table), stopSignal(stopSignal), id(id) { }
+
+    // Searches position, printing a line per completed depth if verbose;
+    // returns the best move, 0 if there is no legal move
+    Move go(Position &position, const SearchLimits &limits, bool verbose = true);
+
+    unsigned long long nodes;
+    int depth;                      // last completed depth
+    int score;                      // its score, from the side to move's view
+    Move pv[MAX_SEARCH_PLY];        // its principal variation
+    int pvLength;
+    TableStats tableStats;          // lookups of the alpha-beta nodes
+
+private:
+    int alphaBeta(Position &position, int depth, int ply, int alpha, int beta);
+    int quiescence(Position &position, int ply, int alpha, int beta);
+    void scoreMoves(const Position &position, const MoveList &moves, int scores[], int ply, Move hashMove) const;
+    bool checkStop();
+    long long elapsed() const;      // milliseconds since go
+
+    TranspositionTable *table;
+    atomic<bool> *stopSignal;
+    int id;
+    SearchLimits limits;
+    chrono::steady_clock::time_point start;
+    bool stopped;
+
+    Move killers[MAX_SEARCH_PLY][2];    // last two quiet moves to cut off at each ply
+    int history[2][64][64];             // [side][from][to]: cutoffs of quiet moves, by depth^2
+    Move pvTable[MAX_SEARCH_PLY][MAX_SEARCH_PLY];
+    int pvTableLength[MAX_SEARCH_PLY];
+};
+
+// Lazy SMP: one Search per thread on the same root, sharing a table and
+// nothing else. What one thread stores cuts off the nodes another reaches,
+// and each helper skips a different set of depths, so the threads search
+// different depths and trees. The main thread alone obeys the time and node limits and
+// reports; when it is done, it stops the helpers. With 1 thread this is
+// Search itself, and as deterministic.
+class SmpSearch {
+public:
+    SmpSearch(int threads, TranspositionTable *table);
+
+    // Searches as Search::go with all threads; returns the main thread's move
+    Move go(Position &position, const SearchLimits &limits, bool verbose = true);
+
+    // Ends a running go from any other thread
+    void stop() { stopSignal = true; }
+
+    Search &main() { return searches[0]; }
+    unsigned long long nodes() const;   // of all threads in the last go
+
+private:
+    vector<Search> searches;
+    atomic<bool> stopSignal;
+};
+
+#endif
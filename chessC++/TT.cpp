@@ -0,0 +1,73 @@
+#include "TT.h"
+
+#define DATA_DEPTH(data) ((int)((data) & 0xFF))
+#define DATA_GENERATION(data) ((uint8_t)((data) >> 8))
+
+TranspositionTable::TranspositionTable(size_t megabytes) : buckets(NULL), count(0), generation(0) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable(){
+    delete[] buckets;
+}
+
+void TranspositionTable::resize(size_t megabytes){
+    delete[] buckets;
+    buckets = NULL;
+    count = 0;
+    size_t wanted = megabytes * 1024 * 1024 / sizeof(TTBucket);
+    if(wanted == 0) return;
+    count = 1;
+    while(count * 2 <= wanted) count *= 2;
+    buckets = new TTBucket[count];
+    clear();
+}
+
+void TranspositionTable::clear(){
+    for(size_t i = 0; i < count; i++){
+        for(int j = 0; j < TT_BUCKET_SIZE; j++){
+            buckets[i].entries[j].check.store(0, memory_order_relaxed);
+            buckets[i].entries[j].data.store(0, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, uint64_t &payload, int &depth) const {
+    if(count == 0) return false;
+    const TTBucket &bucket = buckets[key & (count - 1)];
+    for(int i = 0; i < TT_BUCKET_SIZE; i++){
+        uint64_t data = bucket.entries[i].data.load(memory_order_relaxed);
+        uint64_t check = bucket.entries[i].check.load(memory_order_relaxed);
+        if((check ^ data) == key && data){
+            payload = data >> 16;
+            depth = DATA_DEPTH(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, uint64_t payload, int depth){
+    if(count == 0) return;
+    TTBucket &bucket = buckets[key & (count - 1)];
+    TTEntry *victim = &bucket.entries[0];
+    int victimWorth = 1 << 30;
+    for(int i = 0; i < TT_BUCKET_SIZE; i++){
+        TTEntry &entry = bucket.entries[i];
+        uint64_t data = entry.data.load(memory_order_relaxed);
+        if((entry.check.load(memory_order_relaxed) ^ data) == key){
+            victim = &entry;
+            break;
+        }
+        // entries of this search outweigh any older one, then deeper wins
+        int worth = DATA_DEPTH(data) + (DATA_GENERATION(data) == generation ? 256 : 0);
+        if(worth < victimWorth){
+            victim = &entry;
+            victimWorth = worth;
+        }
+    }
+    uint64_t data = payload << 16 | (uint64_t)generation << 8 | (uint64_t)(depth & 0xFF);
+    victim->data.store(data, memory_order_relaxed);
+    victim->check.store(key ^ data, memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef _TT_H_
+#define _TT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+using namespace std;
+
+// Probes and hits, kept by each user of a table so that threads sharing it
+// do not fight over a counter
+struct TableStats {
+    unsigned long long probes;
+    unsigned long long hits;
+};
+
+// One entry: a 64-bit data word stored next to key ^ data. A writer stores
+// the two words one after the other with no lock, so a reader racing it may
+// see a torn pair; the pair then fails the XOR check and reads as a miss.
+//   data bits  0-7   depth
+//   data bits  8-15  generation of the search that stored it
+//   data bits 16-63  payload, meaning left to the user
+struct TTEntry {
+    atomic<uint64_t> check;
+    atomic<uint64_t> data;
+};
+
+#define TT_BUCKET_SIZE 4
+
+// 4 entries of 16 bytes fill one cache line, so a probe touches one line
+struct alignas(64) TTBucket {
+    TTEntry entries[TT_BUCKET_SIZE];
+};
+
+// Fixed-size hash table of positions by Zobrist key, shared as is by any
+// number of threads. A key goes to one bucket; storing it there replaces its
+// own entry, else an entry left by an earlier search, else the shallowest.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 0);
+    ~TranspositionTable();
+
+    // Drops all entries and takes the largest power of two of buckets that
+    // fits; 0 disables the table
+    void resize(size_t megabytes);
+    void clear();
+    // Ages the entries stored so far, so that they are replaced first
+    void newSearch() { generation++; }
+
+    // False if key is not in the table
+    bool probe(uint64_t key, uint64_t &payload, int &depth) const;
+    void store(uint64_t key, uint64_t payload, int depth);
+
+    size_t size() const { return count; }   // buckets
+
+private:
+    TTBucket *buckets;
+    size_t count;
+    uint8_t generation;
+};
+
+#endif
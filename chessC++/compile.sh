@@ -0,0 +1,10 @@
+#!/bin/sh
+
+g++ -O2 -c Bitboard.cpp
+g++ -O2 -c Board.cpp
+g++ -O2 -c Position.cpp
+g++ -O2 -c TT.cpp
+g++ -O2 -c Eval.cpp
+g++ -O2 -fopenmp -c Search.cpp
+g++ -O2 -fopenmp -c Perft.cpp
+g++ -O2 -fopenmp main.cpp Bitboard.o Board.o Position.o TT.o Eval.o Search.o Perft.o -o chess
@@ -2,272 +2,63 @@
 #include <string>
 #include <vector>
 #include <deque>
-#include <set>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
+#include "Bitboard.h"
+#include "Board.h"
+#include "Position.h"
+#include "Perft.h"
+#include "Search.h"
 
 using namespace std;
 
-// Pieces
-#define EMPTY 0
-#define PAWN 1
-#define ROOK 2
-#define KNIGHT 3
-#define BISHOP 4
-#define QUEEN 5
-#define KING 6
-#define PIECE 7
-#define BLACK 8
-#define WHITE 0
-
-// Castling constants
-#define WHITE_KING_SIDE 0
-#define WHITE_QUEEN_SIDE 1
-#define BLACK_KING_SIDE 2
-#define BLACK_QUEEN_SIDE 3
-#define WHITE_KING 0
-#define BLACK_KING 1
-
-#define TESTING 1
-
-uint8_t board[64] = {0};
-bool turn = 0; // White turn = 0, black turn = 1
-vector<int> capturedPieces;
-bool rookCanCastle[4] = {1,1,1,1}; // White King side, White Queen side, Black King side, Black Queen side
-bool kingHasNotMoved[2] = {1,1}; // Black King, White King
-int enPassantTile = -1;
-int enPassantPawnPosition = -1;
-
 // Forward declarations
-int getPiece(int);
-int getColor(int);
-void displayBoard(uint8_t * = board);
-void displayBoardValues(uint8_t * = board);
-int initBoard(const char*, uint8_t * = board);
-void movePiece(int, int, uint8_t * = board, bool = false);
-bool isInCheck(int , uint8_t * = board);
-bool canKingCastle(int, uint8_t * = board);
-bool addMove(int, int, vector<int> &res, int, uint8_t * = board);
-bool addMove(int, int, set<int> &res, int, uint8_t * = board);
-bool isInCheckAfterMoving(int, int, uint8_t * = board);
-vector<int> checkValidMoves(int , uint8_t * = board);
-vector<int> checkAllValidMoves(int , uint8_t * = board);
-set<int> checkAllPosBeingAttackedBy(int, uint8_t * = board);
-vector<int> filterValidMoves(int, vector<int>, uint8_t * = board);
+void movePiece(Position &, int, int);
+bool isSquareAttacked(int, int, const uint8_t *);
+int findKing(int, const uint8_t *);
+uint64_t pinnedPieces(int, const uint8_t *);
+bool mayExposeKing(int, int, int, bool, uint64_t, const Position &);
+bool isInCheck(int, const Position &);
+bool canKingCastle(int, const Position &);
+bool addMove(int, int, uint64_t &res, int, const uint8_t *);
+bool isInCheckAfterMoving(int, int, Position &);
+uint64_t checkValidTargets(int, const Position &);
+void checkValidMoves(int, const Position &, MoveList &);
+void checkAllValidMoves(int, Position &, MoveList &);
+uint64_t checkAllPosBeingAttackedBy(int, const Position &);
+void filterValidMoves(const MoveList &, Position &, MoveList &);
 
 // Implementations
-void displayBoardValues(uint8_t * board){
-    for(int r = 0; r < 8; r++){
-        for(int c = 0; c < 8; c++){
-            cout << "[" << board[r*8+c] << "] ";
-        }
-        cout << endl;
-    }
-}
-
-void displayBoard(uint8_t * board){
-    for(int r = 0; r < 8; r++){
-        for(int c = 0; c < 8; c++){
-            int piece = board[r * 8 + c];
-            char pieceCh = ' ';
-
-            switch (piece)
-            {
-            case 1: pieceCh = 'P'; break;
-            case 2: pieceCh = 'R'; break;
-            case 3: pieceCh = 'N'; break;
-            case 4: pieceCh = 'B'; break;
-            case 5: pieceCh = 'Q'; break;
-            case 6: pieceCh = 'K'; break;
-            case 9: pieceCh = 'p'; break;
-            case 10: pieceCh = 'r'; break;
-            case 11: pieceCh = 'n'; break;
-            case 12: pieceCh = 'b'; break;
-            case 13: pieceCh = 'q'; break;
-            case 14: pieceCh = 'k'; break;
-            default: break;
-            }
-            cout << "[" << pieceCh << "] ";
-        }
-        cout << endl;
-    }
-}
-
-void displayInfo(){
-    if(turn == WHITE){
+void displayInfo(const Position &game){
+    if(game.side == WHITE){
         cout << "White's Turn!" << endl;
     } else {
         cout << "Black's Turn!" << endl;
     }
 }
 
-int getPiece(int n){
-    return (n & PIECE);
-}
-
-int getColor(int n){
-    return (n & BLACK) ;
-}
-
 bool isRowColValid(int r, int c){
     return r >= 0 && r < 8 && c >= 0 && c < 8;
 }
 
-int initBoard(const char* fen, uint8_t * board){
-    int i = 0; // index in the board array
-    while (*fen && *fen != ' ') {
-        if (isdigit(*fen)) {
-            i += *fen - '0';
-        } else if (*fen == '/') {
-            fen++; // Move to the next character after '/'
-            continue;
-        } else {
-            int piece = EMPTY;
-            switch(*fen) {
-                case 'P': piece = PAWN | WHITE; break;
-                case 'R': piece = ROOK | WHITE; break;
-                case 'N': piece = KNIGHT | WHITE; break;
-                case 'B': piece = BISHOP | WHITE; break;
-                case 'Q': piece = QUEEN | WHITE; break;
-                case 'K': piece = KING | WHITE; break;
-                case 'p': piece = PAWN | BLACK; break;
-                case 'r': piece = ROOK | BLACK; break;
-                case 'n': piece = KNIGHT | BLACK; break;
-                case 'b': piece = BISHOP | BLACK; break;
-                case 'q': piece = QUEEN | BLACK; break;
-                case 'k': piece = KING | BLACK; break;
-                default:
-                    cerr << "Invalid character in FEN string." << endl;
-                    return -1;
-            }
-            board[i++] = piece;
-        }
-        fen++;
-    }
-    
-    return 0;
-}
-
 // Assuming input is valid and not being checked
-// Testing Mode does not change game state after calling
-void movePiece(int ori, int pos, uint8_t * board, bool testingMode){
-    if(!board[ori]) {
+void movePiece(Position &game, int ori, int pos){
+    if(!game.squares[ori]) {
         cout << "Empty tile!" << endl;
         return;
     }
 
-    int piece = getPiece(board[ori]);
-    int color = getColor(board[ori]);
-
-    // If target position is empty, move to empty space
-    if(!board[pos]){
-        // All pawn logics, including promotion, enpassant, move 2, move 1
-        if(piece == PAWN){
-            // If it's pawn and reached last row, promote piece
-            if((pos >=0 && pos <8) || (pos >=56 && pos <64)){
-                board[pos] = (color | QUEEN); // Need to separate this for it's own function
-                board[ori] = 0;
-                if(!testingMode){
-                    enPassantTile = -1;
-                    enPassantPawnPosition = -1;
-                    turn = !turn;
-                }
-                return;
-            }
-            // If it's pawn and attack sqaure can be enpassant
-            if(pos == enPassantTile){
-                board[pos] = board[ori];
-                board[ori] = 0;
-                capturedPieces.push_back(board[enPassantPawnPosition]);
-                board[enPassantPawnPosition] = 0;
-                if(!testingMode){
-                    enPassantTile = -1;
-                    enPassantPawnPosition = -1;
-                    turn = !turn;
-                }
-                return;
-            }
-
-            // If it's pawn and moved 2 squares mark enpassant info
-            if(abs(pos-ori)==16){
-                board[pos] = board[ori];
-                board[ori] = 0;
-                if(!testingMode){
-                    enPassantTile = ori;
-                    enPassantPawnPosition = pos;
-                    turn = !turn;
-                }
-                return;
-            }
-
-            // If it's pawn and moved 1 square
-            board[pos] = board[ori];
-            board[ori] = 0;
-            if(!testingMode){
-                enPassantTile = -1;
-                enPassantPawnPosition = -1;
-                turn = !turn;
-            }
-            return;
-        } 
-
-        // Castle move logic
-        if(piece == KING && (abs(pos-ori)==2)){
-            if((pos-ori)==-2){ // Queen Side Castle
-                board[ori-1]=board[ori-4];
-                board[ori-4]=0;
-            } else { // King Side Castle
-                board[ori+1]=board[ori+3];
-                board[ori+3]=0;
-            }
-        }
-
-        // If king moves, remove all castle availability
-        if(piece == KING && !testingMode){
-            if(color==WHITE){
-                rookCanCastle[WHITE_KING_SIDE] = 0;
-                rookCanCastle[WHITE_QUEEN_SIDE] = 0;
-
-                kingHasNotMoved[WHITE_KING] = 0;
-            } else {
-                rookCanCastle[BLACK_KING_SIDE] = 0;
-                rookCanCastle[BLACK_QUEEN_SIDE] = 0;
-
-                kingHasNotMoved[BLACK_KING] = 0;
-            }
-        }
-
-        // If rook moves, remove the castle availability of that side
-        if(piece == ROOK && !testingMode){
-            if(color==WHITE){
-                if(ori == 56) rookCanCastle[WHITE_KING_SIDE] = 0;
-                if(ori == 63) rookCanCastle[WHITE_QUEEN_SIDE] = 0;
-            } else {
-                if(ori == 0) rookCanCastle[BLACK_KING_SIDE] = 0;
-                if(ori == 7) rookCanCastle[BLACK_QUEEN_SIDE] = 0;
-            }
-        }
-
-        // All other piece when moving to empty square
-        board[pos] = board[ori];
-        board[ori] = 0;
-        
-        if(!testingMode){
-            enPassantTile = -1;
-            enPassantPawnPosition = -1;
-            turn = !turn;
-        }
-        return;
-    }  
-
-    // If there is a piece on the target position, capture enemy piece
-    capturedPieces.push_back(board[pos]);
-    board[pos] = board[ori];
-    board[ori] = 0;
-    enPassantTile = -1;
-    enPassantPawnPosition = -1;
-    turn = !turn;
+    // If it's pawn and reached last row, promote piece
+    int promotion = 0;
+    if(getPiece(game.squares[ori]) == PAWN && ((pos >=0 && pos <8) || (pos >=56 && pos <64))){
+        promotion = QUEEN; // Need to separate this for it's own function
+    }
+    game.makeMove(game.encodeMove(ori, pos, promotion));
 }
 
-bool pieceInPath(int ori, int pos, uint8_t* board) {
+bool pieceInPath(int ori, int pos, const uint8_t* board) {
     // Board is an 8x8 chess board
     int oriRow = ori / 8;
     int oriCol = ori % 8;
@@ -317,105 +108,64 @@ bool pieceInPath(int ori, int pos, uint8_t* board) {
     return false; // No piece found in the path
 }
 
-bool canKingCastle(int side, uint8_t * board) {
+bool canKingCastle(int side, const Position &game) {
+    const uint8_t * board = game.squares;
     int kingPos, rookPos;
-    set<int> underAttack;
+    if (!(game.castling & (1 << side))) return false;
     if (side == WHITE_KING_SIDE) {
         kingPos = 60; rookPos = 63; 
         if(pieceInPath(kingPos,rookPos,board)) return false;
-        underAttack = checkAllPosBeingAttackedBy(BLACK);
         for(int i=kingPos; i<=62; i++){
-            if(underAttack.find(i)!=underAttack.end()) return false;
+            if(isSquareAttacked(i, BLACK, board)) return false;
         }
-        // // DEBUG
-        // cout << "WK HAS NOT MOVED = " << kingHasNotMoved[WHITE_KING] << endl;
-        // cout << "ROOK CAN CASTLE = " << rookCanCastle[WHITE_KING_SIDE] << endl;
-        // // DEBUG
-
-        if (!kingHasNotMoved[WHITE_KING] || !rookCanCastle[WHITE_KING_SIDE]) return false;
     } else if (side == WHITE_QUEEN_SIDE) {
         kingPos = 60; rookPos = 56; 
         if(pieceInPath(kingPos,rookPos,board)) return false;
-        underAttack = checkAllPosBeingAttackedBy(BLACK);
         for(int i=58; i<=kingPos; i++){
-            if(underAttack.find(i)!=underAttack.end()) return false;
+            if(isSquareAttacked(i, BLACK, board)) return false;
         }
-        if (!kingHasNotMoved[WHITE_KING] || !rookCanCastle[WHITE_QUEEN_SIDE]) return false;
     } else if (side == BLACK_KING_SIDE) {
         kingPos = 4; rookPos = 7; 
         if(pieceInPath(kingPos,rookPos,board)) return false;
-
-        underAttack = checkAllPosBeingAttackedBy(WHITE);
         for(int i=kingPos; i<=6; i++){
-            if(underAttack.find(i)!=underAttack.end()) return false;
+            if(isSquareAttacked(i, WHITE, board)) return false;
         }
-        if (!kingHasNotMoved[BLACK_KING] || !rookCanCastle[BLACK_KING_SIDE]) return false;
     } else if (side == BLACK_QUEEN_SIDE) {
         kingPos = 4; rookPos = 0; 
         if(pieceInPath(kingPos,rookPos,board)) return false;
-
-        underAttack = checkAllPosBeingAttackedBy(WHITE);
         for(int i=2; i<=kingPos; i++){
-            if(underAttack.find(i)!=underAttack.end()) return false;
+            if(isSquareAttacked(i, WHITE, board)) return false;
         }
-        if (!kingHasNotMoved[BLACK_KING] || !rookCanCastle[BLACK_QUEEN_SIDE]) return false;
     }
 
     return true;
 }
 
-bool addMove(int r, int c, vector<int> &res, int color, uint8_t * board){
+// Adds square (r, c) to the set of squares res, one bit per square
+bool addMove(int r, int c, uint64_t &res, int color, const uint8_t * board){
     if (isRowColValid(r, c)) {
         int index = r * 8 + c;
         if (!board[index] || getColor(board[index]) != color) {
-
-            res.push_back(index);
+            res |= 1ULL << index;
             return board[index] == EMPTY; // Return true if the tile is empty, false if it's occupied
         }
     }
     return 0;
 }
 
-bool addMove(int r, int c, set<int> &res, int color, uint8_t * board){
-    if (isRowColValid(r, c)) {
-        int index = r * 8 + c;
-        if (!board[index] || getColor(board[index]) != color) {
-            res.insert(index);
-            return board[index] == EMPTY;// Return true if the tile is empty, false if it's occupied
-        }
-    }
-    return 0;
-}
-
-bool isInCheckAfterMoving(int ori, int pos, uint8_t * board){
-    int color = getColor(board[ori]);
-    int piece = getPiece(board[ori]);
-    uint8_t * tempBoard = new uint8_t[64];
-    for(int i=0; i<64; i++){
-        tempBoard[i] = board[i];
-    }
-    
-    movePiece(ori, pos, tempBoard, TESTING);
-
-    // // DEBUG 
-    // cout << "Color: " << color << endl;
-    // cout << "Temp Board: " << endl;
-    // displayBoard(tempBoard);
-    // bool x = isInCheck(color, tempBoard);
-    // cout << "IS IN CHECK???? : "<< x << endl;
-    // // DEBUG
-
-    if(isInCheck(color, tempBoard)){
-        delete[] tempBoard;
-        return true;
-    }
-    delete[] tempBoard;
-    return false;
+// Plays the move on game and takes it back
+bool isInCheckAfterMoving(int ori, int pos, Position &game){
+    int color = getColor(game.squares[ori]);
+    movePiece(game, ori, pos);
+    bool res = isInCheck(color, game);
+    game.unmakeMove();
+    return res;
 }
 
-// Need to implement in check
-vector<int> checkValidMoves(int pos, uint8_t * board) {
-    vector<int> res;
+// Squares the piece on pos can move to, one bit per square
+uint64_t checkValidTargets(int pos, const Position &game) {
+    const uint8_t * board = game.squares;
+    uint64_t res = 0;
 
     if (!board[pos]) {
         cout << "Empty tile!" << endl;
@@ -438,36 +188,36 @@ vector<int> checkValidMoves(int pos, uint8_t * board) {
             if (color == WHITE) {
                 // Forward moves
                 if(!board[(row - 1) * 8 + col]) {
-                    addMove(row - 1, col, res, WHITE);
+                    addMove(row - 1, col, res, WHITE, board);
                     if (row == 6 && !board[(row - 2) * 8 + col]) {
-                        addMove(row - 2, col, res, WHITE);
+                        addMove(row - 2, col, res, WHITE, board);
                     }
                 }
                 
                 // Diagonal caputures
-                if(isRowColValid(row - 1, col - 1)&&board[(row - 1) * 8 + col-1]) addMove(row - 1, col - 1, res, WHITE);
-                if(isRowColValid(row - 1, col + 1)&&board[(row - 1) * 8 + col+1]) addMove(row - 1, col + 1, res, WHITE);
+                if(isRowColValid(row - 1, col - 1)&&board[(row - 1) * 8 + col-1]) addMove(row - 1, col - 1, res, WHITE, board);
+                if(isRowColValid(row - 1, col + 1)&&board[(row - 1) * 8 + col+1]) addMove(row - 1, col + 1, res, WHITE, board);
 
                 // If enpassant available
-                if(isRowColValid(row - 1, col - 1)&&((row - 1) * 8 + col-1)==enPassantTile) addMove(row - 1, col - 1, res, WHITE);
-                if(isRowColValid(row - 1, col + 1)&&((row - 1) * 8 + col+1)==enPassantTile) addMove(row - 1, col + 1, res, WHITE);
+                if(isRowColValid(row - 1, col - 1)&&((row - 1) * 8 + col-1)==game.epSquare) addMove(row - 1, col - 1, res, WHITE, board);
+                if(isRowColValid(row - 1, col + 1)&&((row - 1) * 8 + col+1)==game.epSquare) addMove(row - 1, col + 1, res, WHITE, board);
 
             } else {
                 // Forward moves
                 if(!board[(row + 1) * 8 + col]){
-                    addMove(row + 1, col, res, BLACK);
+                    addMove(row + 1, col, res, BLACK, board);
                     if (row == 1 && !board[(row + 2) * 8 + col]) {
-                        addMove(row + 2, col, res, BLACK);
+                        addMove(row + 2, col, res, BLACK, board);
                     }
                 }
                 
                 // Diagonal caputures
-                if(isRowColValid(row + 1, col - 1)&&board[(row + 1) * 8 + col-1]) addMove(row + 1, col - 1, res, BLACK);
-                if(isRowColValid(row + 1, col + 1)&&board[(row + 1) * 8 + col+1]) addMove(row + 1, col + 1, res, BLACK);
+                if(isRowColValid(row + 1, col - 1)&&board[(row + 1) * 8 + col-1]) addMove(row + 1, col - 1, res, BLACK, board);
+                if(isRowColValid(row + 1, col + 1)&&board[(row + 1) * 8 + col+1]) addMove(row + 1, col + 1, res, BLACK, board);
 
                 // If enpassant available
-                if(isRowColValid(row + 1, col - 1)&&((row + 1) * 8 + col-1)==enPassantTile) addMove(row + 1, col - 1, res, BLACK);
-                if(isRowColValid(row + 1, col + 1)&&((row + 1) * 8 + col+1)==enPassantTile) addMove(row + 1, col + 1, res, BLACK);
+                if(isRowColValid(row + 1, col - 1)&&((row + 1) * 8 + col-1)==game.epSquare) addMove(row + 1, col - 1, res, BLACK, board);
+                if(isRowColValid(row + 1, col + 1)&&((row + 1) * 8 + col+1)==game.epSquare) addMove(row + 1, col + 1, res, BLACK, board);
             }
             break;
 
@@ -549,17 +299,17 @@ vector<int> checkValidMoves(int pos, uint8_t * board) {
             // cout << "DEBUG - " << "AFTER CHECKING DIRECTIONS" << " " << endl;
             // // DEBUG
 
-            if(turn!=color) return res;
+            if(game.side!=color) return res;
 
             // Castling
-            if(color==WHITE && kingHasNotMoved[WHITE_KING]){
-                if(canKingCastle(WHITE_KING_SIDE)) addMove(row, col+2, res, color, board);
-                if(canKingCastle(WHITE_QUEEN_SIDE)) addMove(row, col-2, res, color, board);
+            if(color==WHITE){
+                if(canKingCastle(WHITE_KING_SIDE, game)) addMove(row, col+2, res, color, board);
+                if(canKingCastle(WHITE_QUEEN_SIDE, game)) addMove(row, col-2, res, color, board);
             } 
 
-            if(color==BLACK && kingHasNotMoved[BLACK_KING]) {
-                if(canKingCastle(BLACK_KING_SIDE)) addMove(row, col+2, res, color, board);
-                if(canKingCastle(BLACK_QUEEN_SIDE)) addMove(row, col-2, res, color, board);
+            if(color==BLACK) {
+                if(canKingCastle(BLACK_KING_SIDE, game)) addMove(row, col+2, res, color, board);
+                if(canKingCastle(BLACK_QUEEN_SIDE, game)) addMove(row, col-2, res, color, board);
             }
             
             break;
@@ -574,8 +324,23 @@ vector<int> checkValidMoves(int pos, uint8_t * board) {
     return res;
 }
 
-vector<int> checkAllValidMoves(int color, uint8_t * board){
-    vector<int> res;
+// Adds the moves of the piece on pos to res; a pawn reaching the last row promotes to a queen
+void checkValidMoves(int pos, const Position &game, MoveList &res){
+    uint64_t targets = checkValidTargets(pos, game);
+    bool pawn = getPiece(game.squares[pos]) == PAWN;
+    while(targets){
+        int to = popLsb(targets);
+        int promotion = (pawn && (to < 8 || to >= 56)) ? QUEEN : 0; // Need to separate this for it's own function
+        res.add(game.encodeMove(pos, to, promotion));
+    }
+}
+
+// Adds the legal moves of color to res
+void checkAllValidMoves(int color, Position &game, MoveList &res){
+    const uint8_t * board = game.squares;
+    int kingPos = findKing(color, board);
+    bool inCheck = kingPos >= 0 && isSquareAttacked(kingPos, color ^ BLACK, board);
+    uint64_t pinned = pinnedPieces(color, board);
     for(int i=0; i<64; i++){
         if(board[i] && getColor(board[i]) == color){
 
@@ -584,9 +349,12 @@ vector<int> checkAllValidMoves(int color, uint8_t * board){
             // vector<int> debugVec;
             // // DEBUG
 
-            for(int r: checkValidMoves(i)){
-                if(!isInCheckAfterMoving(i, r, board)) {
-                    res.push_back(r);
+            MoveList moves;
+            checkValidMoves(i, game, moves);
+            for(Move move: moves){
+                int r = MOVE_TO(move);
+                if(!mayExposeKing(i, r, kingPos, inCheck, pinned, game) || !isInCheckAfterMoving(i, r, game)) {
+                    res.add(move);
                     // // DEBUG
                     // debugVec.push_back(r);
                     // cout << r << " ";
@@ -613,11 +381,12 @@ vector<int> checkAllValidMoves(int color, uint8_t * board){
     // for(int i:res) cout << i << " ";
     // cout << endl;
     // //
-    return res;
 }
 
-set<int> checkAllPosBeingAttackedBy(int color, uint8_t * board){
-    set<int> res;
+// Squares attacked by the pieces of color, one bit per square
+uint64_t checkAllPosBeingAttackedBy(int color, const Position &game){
+    const uint8_t * board = game.squares;
+    uint64_t res = 0;
 
     // Iterate through all squares on the board
     for (int i = 0; i < 64; ++i) {
@@ -630,21 +399,20 @@ set<int> checkAllPosBeingAttackedBy(int color, uint8_t * board){
                 // Pawn attacks
                 case PAWN:
                     if (color == WHITE) {
-                        if (isRowColValid(row - 1, col - 1)) addMove(row - 1, col - 1, res, color);
-                        if (isRowColValid(row - 1, col + 1)) addMove(row - 1, col + 1, res, color);
+                        if (isRowColValid(row - 1, col - 1)) addMove(row - 1, col - 1, res, color, board);
+                        if (isRowColValid(row - 1, col + 1)) addMove(row - 1, col + 1, res, color, board);
                     } else {
-                        if (isRowColValid(row + 1, col - 1)) addMove(row + 1, col - 1, res, color);
-                        if (isRowColValid(row + 1, col + 1)) addMove(row + 1, col + 1, res, color);
+                        if (isRowColValid(row + 1, col - 1)) addMove(row + 1, col - 1, res, color, board);
+                        if (isRowColValid(row + 1, col + 1)) addMove(row + 1, col + 1, res, color, board);
                     }
                     break;
-                // Other pieces use checkValidMoves
+                // Other pieces use checkValidTargets
                 default:
                     // // Debug
                     // cout << "DEBUG - starting with " << i << endl;
                     // // Debug
 
-                    vector<int> moves = checkValidMoves(i, board);
-                    for(int move:moves) res.insert(move);
+                    res |= checkValidTargets(i, game);
 
                     // // Debug
                     // cout << "DEBUG - done with " << i << ", moves: ";
@@ -659,59 +427,403 @@ set<int> checkAllPosBeingAttackedBy(int color, uint8_t * board){
     return res;
 }
 
-vector<int> filterValidMoves(int ori, vector<int> valids, uint8_t * board){
-    vector<int> filtered;
-    for(int i:valids){
-        if(!isInCheckAfterMoving(ori,i)) filtered.push_back(i);
+void filterValidMoves(const MoveList &valids, Position &game, MoveList &filtered){
+    for(Move move:valids){
+        if(!isInCheckAfterMoving(MOVE_FROM(move),MOVE_TO(move),game)) filtered.add(move);
     }
-    return filtered;
 }
 
-bool isInCheck(int color, uint8_t * board){
-    int enemyColor = WHITE;
-    if(color == WHITE) enemyColor = BLACK;
+// Looks outward from square: along the 8 rays for the first piece, which
+// attacks it if it's a slider of that ray, and at the knight, pawn and king offsets
+bool isSquareAttacked(int square, int byColor, const uint8_t * board){
+    int directions[8][2] = {
+        {-1, 0}, {1, 0}, {0, -1}, {0, 1}, // Vertical and horizontal directions
+        {-1, -1}, {1, 1}, {-1, 1}, {1, -1}  // Diagonal directions
+    };
+    int row = square / 8;
+    int col = square % 8;
+
+    for(int i = 0; i < 8; i++){
+        int r = row + directions[i][0], c = col + directions[i][1];
+        if(isRowColValid(r, c) && board[r * 8 + c] == (byColor | KING)) return true;
+        while(isRowColValid(r, c) && !board[r * 8 + c]){
+            r += directions[i][0];
+            c += directions[i][1];
+        }
+        if(!isRowColValid(r, c) || getColor(board[r * 8 + c]) != byColor) continue;
+        int piece = getPiece(board[r * 8 + c]);
+        if(piece == QUEEN || piece == (i < 4 ? ROOK : BISHOP)) return true;
+    }
 
-    // //DEBUG
-    // cout << "IN isInCheck " << endl;
-    // displayBoard(board);
-    // cout << "isInCheck BOARD ABOVE" << endl;
-    // //DEBUG
+    for (int i = -2; i <= 2; ++i) {
+        for (int j = -2; j <= 2; ++j) {
+            if (abs(i) != abs(j) && i != 0 && j != 0 && isRowColValid(row + i, col + j)
+                && board[(row + i) * 8 + col + j] == (byColor | KNIGHT)) return true;
+        }
+    }
 
-    set<int> enemyAttacks = checkAllPosBeingAttackedBy(enemyColor, board);
+    // White pawns attack upwards, so from the row below the square
+    int pawnRow = (byColor == WHITE) ? row + 1 : row - 1;
+    if(isRowColValid(pawnRow, col - 1) && board[pawnRow * 8 + col - 1] == (byColor | PAWN)) return true;
+    if(isRowColValid(pawnRow, col + 1) && board[pawnRow * 8 + col + 1] == (byColor | PAWN)) return true;
+    return false;
+}
 
-    for(int i:enemyAttacks){
-        if(getColor(board[i])==color && getPiece(board[i])==KING){
-            return true;
+int findKing(int color, const uint8_t * board){
+    for(int i=0; i<64; i++){
+        if(board[i] == (color | KING)) return i;
+    }
+    return -1;
+}
+
+bool isInCheck(int color, const Position &game){
+    const uint8_t * board = game.squares;
+    int kingPos = findKing(color, board);
+    return kingPos >= 0 && isSquareAttacked(kingPos, color ^ BLACK, board);
+}
+
+// Pieces of color that are the only piece between their king and an enemy
+// slider of that ray, one bit per square
+uint64_t pinnedPieces(int color, const uint8_t * board){
+    int directions[8][2] = {
+        {-1, 0}, {1, 0}, {0, -1}, {0, 1}, // Vertical and horizontal directions
+        {-1, -1}, {1, 1}, {-1, 1}, {1, -1}  // Diagonal directions
+    };
+    int kingPos = findKing(color, board);
+    uint64_t res = 0;
+    if(kingPos < 0) return res;
+
+    for(int i = 0; i < 8; i++){
+        int r = kingPos / 8, c = kingPos % 8;
+        int own = -1;
+        while(true){
+            r += directions[i][0];
+            c += directions[i][1];
+            if(!isRowColValid(r, c)) break;
+            int piece = board[r * 8 + c];
+            if(!piece) continue;
+            if(getColor(piece) == color){
+                if(own >= 0) break; // two own pieces: no pin
+                own = r * 8 + c;
+                continue;
+            }
+            if(own >= 0 && (getPiece(piece) == QUEEN || getPiece(piece) == (i < 4 ? ROOK : BISHOP))){
+                res |= 1ULL << own;
+            }
+            break;
         }
     }
+    return res;
+}
 
-    return false;
+// Whether the move from ori to pos may leave the king in check, so that it
+// has to be played to know: a king move, en passant, a pinned piece, or any
+// move while in check. The other moves are legal.
+bool mayExposeKing(int ori, int pos, int kingPos, bool inCheck, uint64_t pinned, const Position &game){
+    return inCheck || ori == kingPos || ((pinned >> ori) & 1)
+        || (getPiece(game.squares[ori]) == PAWN && pos == game.epSquare);
 }
 
-bool isCheckMate(int color, uint8_t * board){
+bool isCheckMate(int color, const Position &game){
+    const uint8_t * board = game.squares;
     int kingpos = -1;
     for(int i=0; i<64; i++){
         if(board[i] == (color | KING)){
             kingpos = i; break;
         }
     }
-    return isInCheck(color) && checkAllPosBeingAttackedBy(color).empty();
+    return isInCheck(color, game) && !checkAllPosBeingAttackedBy(color, game);
 }
 
-// // PERFORMANCE TESTING
-// // Need to implement
-// unsigned long long perft(int depth, uint8_t * board){
-//     unsigned long long res = 0;
-//     uint8_t * tempBoard = new uint8_t[64];
-//     if(depth == 0) return res;
+// GENERATOR COMPARISON
+// The board[64] generator above against the bitboard generator of Board.h:
+// both count the leaves of the move tree (perft) from the same position
+
+// Plays every legal move on game, and takes it back
+unsigned long long perftMailbox(Position &game, int depth){
+    if(depth == 0) return 1;
+
+    unsigned long long nodes = 0;
+    int color = game.side;
+    int kingPos = findKing(color, game.squares);
+    bool inCheck = kingPos >= 0 && isSquareAttacked(kingPos, color ^ BLACK, game.squares);
+    uint64_t pinned = pinnedPieces(color, game.squares);
+    for(int i = 0; i < 64; i++){
+        if(!game.squares[i] || getColor(game.squares[i]) != color) continue;
+        MoveList moves;
+        checkValidMoves(i, game, moves);
+        for(Move move: moves){
+            int r = MOVE_TO(move);
+            if(mayExposeKing(i, r, kingPos, inCheck, pinned, game) && isInCheckAfterMoving(i, r, game)) continue;
+            game.makeMove(move);
+            nodes += perftMailbox(game, depth - 1);
+            game.unmakeMove();
+        }
+    }
+    return nodes;
+}
+
+// Prints nodes and nodes per second of both generators for depths 1..maxDepth from fen
+void compareGenerators(const char* fen, int maxDepth){
+    Position position;
+    if(initBoard(fen, position) < 0) return;
+
+    cout << "depth\tmailbox nodes\tmailbox nps\tmailbox allocs\tbitboard nodes\tbitboard nps\tbitboard allocs\tspeedup" << endl;
+    for(int depth = 1; depth <= maxDepth; depth++){
+        long long allocated = allocationCount();
+        auto start = chrono::steady_clock::now();
+        unsigned long long mailboxNodes = perftMailbox(position, depth);
+        double mailboxTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long mailboxAllocs = allocationCount() - allocated;
+
+        allocated = allocationCount();
+        start = chrono::steady_clock::now();
+        unsigned long long bitboardNodes = perft(position, depth);
+        double bitboardTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long bitboardAllocs = allocationCount() - allocated;
+
+        double mailboxNps = mailboxNodes / max(mailboxTime, 1e-9);
+        double bitboardNps = bitboardNodes / max(bitboardTime, 1e-9);
+        cout << depth << "\t" << mailboxNodes << "\t" << (long long)mailboxNps << "\t" << mailboxAllocs << "\t"
+             << bitboardNodes << "\t" << (long long)bitboardNps << "\t" << bitboardAllocs << "\t"
+             << bitboardNps / mailboxNps << endl;
+    }
+}
+
+// MOVE GENERATION
+// Legal move generations per second of both generators, over the positions of the perft suite
+void benchmarkMoveGeneration(double seconds){
+    cout << "position\tlegal moves\tmailbox gen/s\tbitboard gen/s\tspeedup" << endl;
+    for(int i = 0; i < perftSuiteSize; i++){
+        Position game;
+        if(initBoard(perftSuite[i].fen, game) < 0) continue;
+
+        long generations = 0;
+        int legal = 0;
+        auto start = chrono::steady_clock::now();
+        double elapsed = 0;
+        do {
+            MoveList moves;
+            checkAllValidMoves(game.side, game, moves);
+            legal = moves.size();
+            generations++;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while(elapsed < seconds);
+        double mailboxRate = generations / elapsed;
+
+        generations = 0;
+        start = chrono::steady_clock::now();
+        do {
+            MoveList moves;
+            game.generateLegalMoves(moves);
+            generations++;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while(elapsed < seconds);
+        double bitboardRate = generations / elapsed;
+
+        cout << perftSuite[i].name << "\t" << legal << "\t" << (long long)mailboxRate << "\t"
+             << (long long)bitboardRate << "\t" << bitboardRate / mailboxRate << endl;
+    }
+}
+
+// SEARCH
+// Searches every position of the perft suite to depth, each with a table of
+// hashMegabytes cleared first (none if 0): the total node count is the same
+// every run, and changes only when the search does
+void benchmarkSearch(int depth, int hashMegabytes){
+    unsigned long long totalNodes = 0;
+    double totalTime = 0;
+    TranspositionTable table(hashMegabytes);
+    cout << "position\tdepth\tscore\tnodes\ttime (s)\tnps\thash hits\tbest move" << endl;
+    for(int i = 0; i < perftSuiteSize; i++){
+        Position game;
+        if(initBoard(perftSuite[i].fen, game) < 0) continue;
+
+        table.clear();
+        Search search(hashMegabytes ? &table : NULL);
+        SearchLimits limits = {depth, 0, 0};
+        auto start = chrono::steady_clock::now();
+        Move best = search.go(game, limits, false);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        totalNodes += search.nodes;
+        totalTime += seconds;
+
+        cout << perftSuite[i].name << "\t" << search.depth << "\t" << search.score << "\t" << search.nodes << "\t"
+             << seconds << "\t" << (long long)(search.nodes / max(seconds, 1e-9)) << "\t"
+             << 100.0 * search.tableStats.hits / max(search.tableStats.probes, 1ULL) << "%\t"
+             << (best ? moveToString(best) : "-") << endl;
+    }
+    cout << "total\t\t\t" << totalNodes << "\t" << totalTime << "\t"
+         << (long long)(totalNodes / max(totalTime, 1e-9)) << endl;
+}
+
+// Evaluations per second over every position of the move trees of the perft
+// suite positions to depth
+void benchmarkEvaluation(int depth){
+    cout << "position\tboards\tevals/s\tscore sum" << endl;
+    for(int i = 0; i < perftSuiteSize; i++){
+        Position game;
+        if(initBoard(perftSuite[i].fen, game) < 0) continue;
+
+        // gathered first, so that only evaluate is timed
+        vector<Board> boards;
+        vector<Position> stack(1, game);
+        while(!stack.empty()){
+            Position position = stack.back();
+            stack.pop_back();
+            boards.push_back(position);
+            if((int)position.history.size() >= depth) continue;
+            MoveList moves;
+            position.generateLegalMoves(moves);
+            for(Move move: moves){
+                position.makeMove(move);
+                stack.push_back(position);
+                position.unmakeMove();
+            }
+        }
+
+        long long sum = 0;
+        int rounds = 0;
+        auto start = chrono::steady_clock::now();
+        double seconds = 0;
+        while(seconds < 0.2){
+            for(const Board &board: boards) sum += evaluate(board);
+            rounds++;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        cout << perftSuite[i].name << "\t" << boards.size() << "\t"
+             << (long long)(boards.size() * rounds / seconds) << "\t" << sum / rounds << endl;
+    }
+}
 
-//     delete[] tempBoard;
-//     return perft(depth-1, tempBoard);
-// }
+// Searches the perft suite positions to depth with 1 to maxThreads threads,
+// a cleared table of hashMegabytes for each: nodes per second, and time to
+// reach the depth against 1 thread
+void benchmarkSmp(int depth, int maxThreads, int hashMegabytes){
+    TranspositionTable table(hashMegabytes);
+    double oneThreadTime = 0;
+    cout << "threads\tnodes\ttime (s)\tnps\ttime-to-depth speedup" << endl;
+    for(int threads = 1; threads <= maxThreads; threads++){
+        unsigned long long totalNodes = 0;
+        double totalTime = 0;
+        for(int i = 0; i < perftSuiteSize; i++){
+            Position game;
+            if(initBoard(perftSuite[i].fen, game) < 0) continue;
+
+            table.clear();
+            SmpSearch search(threads, hashMegabytes ? &table : NULL);
+            SearchLimits limits = {depth, 0, 0};
+            auto start = chrono::steady_clock::now();
+            search.go(game, limits, false);
+            totalTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            totalNodes += search.nodes();
+        }
+        if(threads == 1) oneThreadTime = totalTime;
+        cout << threads << "\t" << totalNodes << "\t" << totalTime << "\t"
+             << (long long)(totalNodes / max(totalTime, 1e-9)) << "\t" << oneThreadTime / max(totalTime, 1e-9) << endl;
+    }
+}
 
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// Value of "--name VALUE" among the arguments, or def
+const char* option(int argc, char* argv[], const char* name, const char* def){
+    for(int i = 1; i + 1 < argc; i++){
+        if(strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+    return def;
+}
+
+// Driver:
+//   chess perft DEPTH [FEN] [--threads N] [--hash MB]    leaves and nodes per second
+//   chess divide DEPTH [FEN] [--threads N] [--hash MB]   leaves under each root move
+//   chess suite [DEPTH] [--threads N]        standard positions against their published counts
+//   chess compare [DEPTH] [FEN]              the board[64] generator against the bitboard one
+//   chess movegen [SECONDS]                  legal move generations per second of both
+//   chess go [FEN] [--depth N] [--movetime MS] [--nodes N] [--hash MB] [--threads N]
+//                                            searches for the best move
+//   chess bench [--depth N] [--hash MB]      searches the perft suite positions to a fixed depth
+//   chess smp [--depth N] [--hash MB] [--threads N]   the same with 1 to N threads
+//   chess eval [DEPTH]                       evaluations per second over the suite's move trees
+// --hash sizes the transposition table: off by default for perft, 16 MB for
+// a search, 0 for none
+// anything else prints the moves of the opening position
+int main(int argc, char* argv[]){
+    initBitboards();
+    initZobrist();
+    initEval();
+    string command = (argc >= 2) ? argv[1] : "";
+    int threads = atoi(option(argc, argv, "--threads", "1"));
+    if(threads < 1) threads = 1;
+
+    if(command == "perft" || command == "divide"){
+        int depth = (argc >= 3) ? atoi(argv[2]) : 5;
+        const char* fen = (argc >= 4 && argv[3][0] != '-') ? argv[3] : START_FEN;
+        Position position;
+        if(initBoard(fen, position) < 0) return 1;
+
+        int hashMegabytes = atoi(option(argc, argv, "--hash", "0"));
+        TranspositionTable table(hashMegabytes);
+        TranspositionTable *hashed = hashMegabytes ? &table : NULL;
+        TableStats stats = {0, 0};
+
+        auto start = chrono::steady_clock::now();
+        unsigned long long nodes = (command == "perft") ? perftParallel(position, depth, threads, hashed, &stats)
+                                                        : divide(position, depth, threads, hashed, &stats);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "perft(" << depth << ") = " << nodes << " in " << seconds << " s = "
+             << (long long)(nodes / max(seconds, 1e-9)) << " nps" << endl;
+        if(hashed){
+            cout << "hash: " << hashMegabytes << " MB, " << stats.hits << " hits of " << stats.probes << " probes ("
+                 << 100.0 * stats.hits / max(stats.probes, 1ULL) << "%)" << endl;
+        }
+        return 0;
+    }
+    if(command == "suite"){
+        int depth = (argc >= 3 && argv[2][0] != '-') ? atoi(argv[2]) : 0;
+        return runPerftSuite(depth, threads) ? 1 : 0;
+    }
+    if(command == "go"){
+        const char* fen = (argc >= 3 && argv[2][0] != '-') ? argv[2] : START_FEN;
+        Position position;
+        if(initBoard(fen, position) < 0) return 1;
+
+        SearchLimits limits;
+        limits.depth = atoi(option(argc, argv, "--depth", "0"));
+        limits.movetime = atoi(option(argc, argv, "--movetime", "0"));
+        limits.nodes = strtoull(option(argc, argv, "--nodes", "0"), NULL, 10);
+        if(!limits.depth && !limits.movetime && !limits.nodes) limits.depth = 6;
+
+        TranspositionTable table(atoi(option(argc, argv, "--hash", "16")));
+        SmpSearch search(threads, table.size() ? &table : NULL);
+        Move best = search.go(position, limits);
+        cout << "bestmove " << (best ? moveToString(best) : "0000") << endl;
+        return 0;
+    }
+    if(command == "bench"){
+        benchmarkSearch(atoi(option(argc, argv, "--depth", "6")), atoi(option(argc, argv, "--hash", "16")));
+        return 0;
+    }
+    if(command == "eval"){
+        benchmarkEvaluation((argc >= 3) ? atoi(argv[2]) : 3);
+        return 0;
+    }
+    if(command == "smp"){
+        benchmarkSmp(atoi(option(argc, argv, "--depth", "7")), atoi(option(argc, argv, "--threads", "4")),
+                     atoi(option(argc, argv, "--hash", "16")));
+        return 0;
+    }
+    if(command == "movegen"){
+        benchmarkMoveGeneration((argc >= 3) ? atof(argv[2]) : 0.5);
+        return 0;
+    }
+    if(command == "compare"){
+        int depth = (argc >= 3) ? atoi(argv[2]) : 4;
+        const char* fen = (argc >= 4) ? argv[3] : START_FEN;
+        compareGenerators(fen, depth);
+        return 0;
+    }
 
-// Driver
-int main(){
     // const char* fen = "rnbqkbnr/pp1ppppp/2p5/8/8/8/PPPPPPPP/RNBQKBNR"; // "w KQkq - 0 1"
     // const char* fen = "r3k2r/p4P1p/2nqbnpb/1ppp1P2/PPPP4/8/5KPP/RNBQ1BNR";
 
@@ -725,23 +837,14 @@ int main(){
     // const char* fen = "R3k2r/8/3p4/2P5/8/8/P7/8";
 
     const char* fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR";
-    enPassantPawnPosition = -1;
-    enPassantTile = -1;
-    kingHasNotMoved[WHITE_KING] = 1;
-    kingHasNotMoved[BLACK_KING] = 1;
-    rookCanCastle[WHITE_KING_SIDE] = 1;
-    rookCanCastle[WHITE_QUEEN_SIDE] = 1;
-    rookCanCastle[BLACK_KING_SIDE] = 1;
-    rookCanCastle[BLACK_QUEEN_SIDE] = 1;
-    turn = 0;
-    
-    initBoard(fen);
+    Position game;
+    initBoard(fen, game);
 
     cout<<endl;
 
-    displayBoard();
+    displayBoard(game);
 
-    // set<int> beingAttacked = checkAllPosBeingAttackedBy(BLACK);
+    // uint64_t beingAttacked = checkAllPosBeingAttackedBy(BLACK, game);
 
     // cout << "Pos being attacked by BLACK: ";
     // for(int i:beingAttacked){
@@ -749,21 +852,22 @@ int main(){
     // }
     // cout << endl;
 
-    // set<int> beingAttackedEnemy = checkAllPosBeingAttackedBy(WHITE);
+    // uint64_t beingAttackedEnemy = checkAllPosBeingAttackedBy(WHITE, game);
     // cout << "Pos being attacked by WHITE: ";
     // for(int i:beingAttackedEnemy){
     //     cout << i << ' ';
     // }
     // cout << endl;
 
-    // cout << "WHITE in check = " << isInCheck(WHITE) << endl;
+    // cout << "WHITE in check = " << isInCheck(WHITE, game) << endl;
 
     cout << endl;
-    vector<int> allVals = checkAllValidMoves(WHITE);
+    MoveList allVals;
+    checkAllValidMoves(WHITE, game, allVals);
     sort(allVals.begin(),allVals.end());
     cout << "WHITE valids: ";
-    for(int i:allVals){
-        cout << i << " ";
+    for(Move move:allVals){
+        cout << moveToString(move) << " ";
     }
     cout << endl;
 